@@ -1,12 +1,22 @@
 #pragma once
 #include "game_object.h"
+#include "transform.h"
 
 #include "raylib.h"
 
-typedef struct Behavior
+// behaviors are tag components with no data, an object gets one component type for each behavior it has
+// that puts every object with the same behavior in archetypes that have it, so a behavior runs as a system over whole transform columns
+typedef enum BehaviorType
 {
-    void (*UpdateFunction)(GameObject*);
-}Behavior;
+    MoveBehavior,
+    RotateBehavior,
+    BehaviorTypeCount
+}BehaviorType;
 
-Behavior* CreateBahavior(void (*updateFunction)(GameObject*));
-Behavior* GetBahaviorComponent(GameObject* object);
\ No newline at end of file
+// updates count transforms in one call
+typedef void (*BehaviorSystem)(Transform2D* transforms, int count, float deltaTime);
+
+ComponentType GetBehaviorComponentType(BehaviorType type);
+
+void AddBehaviorComponent(GameObject* object, BehaviorType type);
+bool GameObjectHasBehavior(GameObject* object, BehaviorType type);
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "game_object.h"
+
+#include <stddef.h>
+
+// components are stored by archetype, every entity with the same set of components shares one
+// an archetype keeps a packed array for each component it has, so a system can walk every transform in order without chasing pointers
+// adding a component moves the entity to the archetype for its new set, and the last entity in the old one fills its row
+
+typedef unsigned int ComponentSignature;
+
+#define COMPONENT_BIT(type) (1u << (type))
+
+typedef struct Archetype
+{
+	ComponentSignature Signature;
+
+	int Count;
+	int Capacity;
+
+	int* Entities;							// the entity in each row
+	void* Columns[ComponentTypeCount];		// a packed array for each component, NULL for ones this archetype doesn't have
+}Archetype;
+
+// where an entity's components are, Archetype is -1 once it is destroyed
+// the entity's signature is kept packed in its own array, so checking what an entity has doesn't touch the archetypes
+typedef struct EntityRecord
+{
+	int Archetype;
+	int Row;
+}EntityRecord;
+
+typedef struct ComponentStore
+{
+	Archetype* Archetypes;
+	int ArchetypeCount;
+
+	EntityRecord* Entities;
+	ComponentSignature* Signatures;
+	int EntityCount;
+	int EntityCapacity;
+
+	// destroyed ids are reused before new ones are added
+	int* FreeEntities;
+	int FreeEntityCount;
+}ComponentStore;
+
+ComponentStore* GetComponentStore();
+void FreeComponentStore();
+
+size_t GetComponentSize(ComponentType type);
+
+// entity ids are reused once destroyed, game objects hold handles that check for that
+int CreateEntity();
+void DestroyEntity(int entity);
+
+// copies value into the entity's component, or zeros it if value is NULL
+// tag components have no data, adding one returns NULL, and the signature says if an entity has it
+// pointers to components move when an entity gains a component or another entity is destroyed, so don't keep them past that
+void* AddEntityComponent(int entity, ComponentType type, const void* value);
+void* GetEntityComponent(int entity, ComponentType type);
+ComponentSignature GetEntitySignature(int entity);
+
+// queries
+// call a function for every entity that has all the components in mask, archetypes without them are skipped without looking at their entities
+// components holds a pointer to each of the entity's components by type, NULL for ones it doesn't have
+// the functions must not add components or destroy entities, that moves rows while they are being walked
+typedef void (*EntityQueryFunction)(int entity, void* components[ComponentTypeCount], void* userData);
+typedef void (*ArchetypeQueryFunction)(Archetype* archetype, void* userData);
+
+void ForEachEntity(ComponentSignature mask, EntityQueryFunction function, void* userData);
+
+// for systems that want to work on whole columns at once
+void ForEachArchetype(ComponentSignature mask, ArchetypeQueryFunction function, void* userData);
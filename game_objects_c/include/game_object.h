@@ -7,32 +7,49 @@ typedef enum ComponentType
 	TransformComponent,
 	SpriteComponent,
 	ShapeComponent,
-	BehaviorComponent
+	MoveBehaviorComponent,		// behaviors are tags with no data, one for each BehaviorType in the same order
+	RotateBehaviorComponent,
+	ComponentTypeCount
 }ComponentType;
 
-typedef struct GameObjectComponent
+// game objects live in a slot map and are referenced by handle
+// a handle stays valid until the object is destroyed, after that the slot's generation changes so the old handle finds nothing even if the slot is reused
+typedef struct GameObjectHandle
 {
-	ComponentType CompType;
-	void* CompValue;
-}GameObjectComponent;
+	int Index;
+	unsigned int Generation;
+}GameObjectHandle;
+
+#define INVALID_GAME_OBJECT ((GameObjectHandle){ -1, 0 })
 
 #define MAX_NAME_SIZE 32
 typedef struct GameObject 
 {
 	char Name[MAX_NAME_SIZE];
 
-	GameObjectComponent* Components;
-	int CompoentSize;
+	// the id of the object's components in the component store
+	int Entity;
 
-	struct GameObject* Parent;
-	struct GameObject* Children;
+	GameObjectHandle Parent;
+	GameObjectHandle* Children;
 	int ChildCount;
 }GameObject;
 
-void InitalizeGameObject(GameObject* object);
-GameObject* AddChildObject(GameObject* parent);
-void DestoryGameObject(GameObject* object);
+GameObjectHandle CreateGameObject();
+GameObjectHandle AddChildObject(GameObjectHandle parent);
+
+// destroys the object and all of its children
+void DestoryGameObject(GameObjectHandle handle);
+
+// frees every object and the slot map itself
+void DestroyAllGameObjects();
+
+// returns NULL if the handle is invalid or the object was destroyed
+// the pointer moves when more objects are created, so keep the handle and look it up again instead of keeping the pointer
+GameObject* GetGameObject(GameObjectHandle handle);
+bool GameObjectHandleIsValid(GameObjectHandle handle);
 
-void GameObjectAddComponent(GameObject* object, ComponentType type, void* componentValue);
+// copies componentValue into the object's new component and returns it, an object only has one of each type
+void* GameObjectAddComponent(GameObject* object, ComponentType type, const void* componentValue);
 bool GameObjectHasComponent(GameObject* object, ComponentType type);
 void* GameObjectGetComponent(GameObject* object, ComponentType type);
\ No newline at end of file
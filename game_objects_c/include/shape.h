@@ -8,5 +8,5 @@ typedef struct Shape
 	float Radius;
 }Shape;
 
-Shape* CreateShape(float radius);
+Shape* AddShapeComponent(GameObject* object, float radius);
 Shape* GetShapeComponent(GameObject* object);
\ No newline at end of file
@@ -8,5 +8,5 @@ typedef struct Sprite
 	Texture2D Texture;
 }Sprite;
 
-Sprite* CreateSprite(Texture2D texture);
+Sprite* AddSpriteComponent(GameObject* object, Texture2D texture);
 Sprite* GetSpriteComponent(GameObject* object);
\ No newline at end of file
@@ -10,5 +10,5 @@ typedef struct Transform2D
 	float Rotation;
 }Transform2D;
 
-Transform2D* CreateTransform();
+Transform2D* AddTransformComponent(GameObject* object);
 Transform2D* GetTransformComponent(GameObject* object);
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "game_object.h"
+#include "transform.h"
+
+#include <stdbool.h>
+
+// the scene graph flattened into arrays in depth first order, so a parent always comes before its children
+// each node keeps its object's world transform, worked out from its local Transform2D component and its parent's world transform
+// only nodes marked dirty, and their children, are worked out again, so a scene where nothing moves costs a single pass over the dirty flags
+
+typedef struct TransformHierarchy
+{
+	int Count;
+	int Capacity;
+
+	GameObjectHandle* Objects;
+	int* Entities;
+	int* Parents;				// the parent's node, -1 for roots
+	Transform2D* World;
+	bool* Dirty;
+
+	// the node for each entity id, -1 for entities not in the hierarchy
+	int* EntityNodes;
+	int EntityNodeCount;
+}TransformHierarchy;
+
+// rebuilds the arrays from the roots and everything under them, call it again when objects are added, removed or reparented
+// every node starts dirty
+void BuildTransformHierarchy(TransformHierarchy* hierarchy, const GameObjectHandle* roots, int rootCount);
+void FreeTransformHierarchy(TransformHierarchy* hierarchy);
+
+// call after changing an object's Transform2D component, its children are updated with it
+void MarkTransformDirty(TransformHierarchy* hierarchy, int entity);
+void MarkTransformsDirty(TransformHierarchy* hierarchy, const int* entities, int count);
+
+// works out the world transform of every dirty node in one pass, then clears the flags
+void UpdateWorldTransforms(TransformHierarchy* hierarchy);
+
+// returns NULL if the entity isn't in the hierarchy
+const Transform2D* GetWorldTransform(const TransformHierarchy* hierarchy, int entity);
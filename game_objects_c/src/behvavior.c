@@ -3,17 +3,23 @@
 #include <stdlib.h>
 
 
-Behavior* CreateBahavior(void (*updateFunction)(GameObject*))
+ComponentType GetBehaviorComponentType(BehaviorType type)
 {
-    Behavior* behavior = malloc(sizeof(Behavior));
-    behavior->UpdateFunction = updateFunction;
-    return behavior;
+    return (ComponentType)(MoveBehaviorComponent + type);
 }
 
-Behavior* GetBahaviorComponent(GameObject* object)
+void AddBehaviorComponent(GameObject* object, BehaviorType type)
 {
     if (object == NULL)
-        return NULL;
+        return;
 
-    return (Behavior*)GameObjectGetComponent(object, BehaviorComponent);
-}
\ No newline at end of file
+    GameObjectAddComponent(object, GetBehaviorComponentType(type), NULL);
+}
+
+bool GameObjectHasBehavior(GameObject* object, BehaviorType type)
+{
+    if (object == NULL)
+        return false;
+
+    return GameObjectHasComponent(object, GetBehaviorComponentType(type));
+}
@@ -0,0 +1,258 @@
+#include "component_store.h"
+
+#include "behavior.h"
+#include "shape.h"
+#include "sprite.h"
+#include "transform.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static ComponentStore Store = { 0 };
+
+static const size_t ComponentSizes[ComponentTypeCount] =
+{
+	sizeof(Transform2D),
+	sizeof(Sprite),
+	sizeof(Shape),
+	0,	// behaviors are tags, so they have no column
+	0,
+};
+
+ComponentStore* GetComponentStore()
+{
+	return &Store;
+}
+
+size_t GetComponentSize(ComponentType type)
+{
+	return ComponentSizes[type];
+}
+
+void FreeComponentStore()
+{
+	for (int i = 0; i < Store.ArchetypeCount; i++)
+	{
+		Archetype* archetype = Store.Archetypes + i;
+		free(archetype->Entities);
+		for (int type = 0; type < ComponentTypeCount; type++)
+			free(archetype->Columns[type]);
+	}
+
+	free(Store.Archetypes);
+	free(Store.Entities);
+	free(Store.Signatures);
+	free(Store.FreeEntities);
+	memset(&Store, 0, sizeof(ComponentStore));
+}
+
+static int FindArchetype(ComponentSignature signature)
+{
+	for (int i = 0; i < Store.ArchetypeCount; i++)
+	{
+		if (Store.Archetypes[i].Signature == signature)
+			return i;
+	}
+
+	// there are only a few distinct sets of components, so a new archetype is rare
+	Store.ArchetypeCount++;
+	Store.Archetypes = realloc(Store.Archetypes, sizeof(Archetype) * Store.ArchetypeCount);
+
+	Archetype* archetype = Store.Archetypes + (Store.ArchetypeCount - 1);
+	memset(archetype, 0, sizeof(Archetype));
+	archetype->Signature = signature;
+
+	return Store.ArchetypeCount - 1;
+}
+
+static int AddArchetypeRow(Archetype* archetype, int entity)
+{
+	if (archetype->Count == archetype->Capacity)
+	{
+		archetype->Capacity = archetype->Capacity == 0 ? 16 : archetype->Capacity * 2;
+		archetype->Entities = realloc(archetype->Entities, sizeof(int) * archetype->Capacity);
+
+		for (int type = 0; type < ComponentTypeCount; type++)
+		{
+			if ((archetype->Signature & COMPONENT_BIT(type)) && ComponentSizes[type] > 0)
+				archetype->Columns[type] = realloc(archetype->Columns[type], ComponentSizes[type] * archetype->Capacity);
+		}
+	}
+
+	archetype->Entities[archetype->Count] = entity;
+	return archetype->Count++;
+}
+
+// moves the last row into the removed one so the arrays stay packed
+static void RemoveArchetypeRow(Archetype* archetype, int row)
+{
+	int last = archetype->Count - 1;
+	if (row != last)
+	{
+		int moved = archetype->Entities[last];
+		archetype->Entities[row] = moved;
+
+		for (int type = 0; type < ComponentTypeCount; type++)
+		{
+			if (archetype->Columns[type] != NULL)
+			{
+				char* column = archetype->Columns[type];
+				memcpy(column + row * ComponentSizes[type], column + last * ComponentSizes[type], ComponentSizes[type]);
+			}
+		}
+
+		Store.Entities[moved].Row = row;
+	}
+
+	archetype->Count--;
+}
+
+static bool EntityIsAlive(int entity)
+{
+	return entity >= 0 && entity < Store.EntityCount && Store.Entities[entity].Archetype >= 0;
+}
+
+int CreateEntity()
+{
+	int entity = 0;
+	if (Store.FreeEntityCount > 0)
+	{
+		entity = Store.FreeEntities[--Store.FreeEntityCount];
+	}
+	else
+	{
+		if (Store.EntityCount == Store.EntityCapacity)
+		{
+			Store.EntityCapacity = Store.EntityCapacity == 0 ? 64 : Store.EntityCapacity * 2;
+			Store.Entities = realloc(Store.Entities, sizeof(EntityRecord) * Store.EntityCapacity);
+			Store.Signatures = realloc(Store.Signatures, sizeof(ComponentSignature) * Store.EntityCapacity);
+			Store.FreeEntities = realloc(Store.FreeEntities, sizeof(int) * Store.EntityCapacity);
+		}
+
+		entity = Store.EntityCount++;
+	}
+	Store.Signatures[entity] = 0;
+
+	// new entities start in the archetype with no components
+	int archetype = FindArchetype(0);
+	Store.Entities[entity].Archetype = archetype;
+	Store.Entities[entity].Row = AddArchetypeRow(Store.Archetypes + archetype, entity);
+
+	return entity;
+}
+
+void DestroyEntity(int entity)
+{
+	if (!EntityIsAlive(entity))
+		return;
+
+	EntityRecord* record = Store.Entities + entity;
+	RemoveArchetypeRow(Store.Archetypes + record->Archetype, record->Row);
+	record->Archetype = -1;
+	record->Row = -1;
+	Store.Signatures[entity] = 0;
+
+	Store.FreeEntities[Store.FreeEntityCount++] = entity;
+}
+
+void* AddEntityComponent(int entity, ComponentType type, const void* value)
+{
+	if (!EntityIsAlive(entity))
+		return NULL;
+
+	EntityRecord* record = Store.Entities + entity;
+	ComponentSignature oldSignature = Store.Signatures[entity];
+	if (oldSignature & COMPONENT_BIT(type))
+		return GetEntityComponent(entity, type);
+
+	// finding the archetype can grow the list, so only take pointers into it after
+	int newIndex = FindArchetype(oldSignature | COMPONENT_BIT(type));
+	Archetype* oldArchetype = Store.Archetypes + record->Archetype;
+	Archetype* newArchetype = Store.Archetypes + newIndex;
+
+	int oldRow = record->Row;
+	int newRow = AddArchetypeRow(newArchetype, entity);
+
+	for (int other = 0; other < ComponentTypeCount; other++)
+	{
+		if (oldArchetype->Columns[other] != NULL)
+		{
+			size_t size = ComponentSizes[other];
+			memcpy((char*)newArchetype->Columns[other] + newRow * size, (char*)oldArchetype->Columns[other] + oldRow * size, size);
+		}
+	}
+
+	void* component = NULL;
+	if (newArchetype->Columns[type] != NULL)
+	{
+		component = (char*)newArchetype->Columns[type] + newRow * ComponentSizes[type];
+		if (value != NULL)
+			memcpy(component, value, ComponentSizes[type]);
+		else
+			memset(component, 0, ComponentSizes[type]);
+	}
+
+	RemoveArchetypeRow(oldArchetype, oldRow);
+	record->Archetype = newIndex;
+	record->Row = newRow;
+	Store.Signatures[entity] = oldSignature | COMPONENT_BIT(type);
+
+	return component;
+}
+
+void* GetEntityComponent(int entity, ComponentType type)
+{
+	if (!EntityIsAlive(entity))
+		return NULL;
+
+	if (!(Store.Signatures[entity] & COMPONENT_BIT(type)))
+		return NULL;
+
+	EntityRecord* record = Store.Entities + entity;
+	Archetype* archetype = Store.Archetypes + record->Archetype;
+	if (archetype->Columns[type] == NULL)
+		return NULL;
+
+	return (char*)archetype->Columns[type] + record->Row * ComponentSizes[type];
+}
+
+ComponentSignature GetEntitySignature(int entity)
+{
+	if (entity < 0 || entity >= Store.EntityCount)
+		return 0;
+
+	// destroyed entities have a signature of 0
+	return Store.Signatures[entity];
+}
+
+void ForEachEntity(ComponentSignature mask, EntityQueryFunction function, void* userData)
+{
+	for (int i = 0; i < Store.ArchetypeCount; i++)
+	{
+		Archetype* archetype = Store.Archetypes + i;
+		if ((archetype->Signature & mask) != mask)
+			continue;
+
+		void* components[ComponentTypeCount] = { 0 };
+		for (int row = 0; row < archetype->Count; row++)
+		{
+			for (int type = 0; type < ComponentTypeCount; type++)
+			{
+				if (archetype->Columns[type] != NULL)
+					components[type] = (char*)archetype->Columns[type] + row * ComponentSizes[type];
+			}
+
+			function(archetype->Entities[row], components, userData);
+		}
+	}
+}
+
+void ForEachArchetype(ComponentSignature mask, ArchetypeQueryFunction function, void* userData)
+{
+	for (int i = 0; i < Store.ArchetypeCount; i++)
+	{
+		Archetype* archetype = Store.Archetypes + i;
+		if ((archetype->Signature & mask) == mask && archetype->Count > 0)
+			function(archetype, userData);
+	}
+}
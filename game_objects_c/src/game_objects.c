@@ -1,87 +1,168 @@
 #include "game_object.h"
+#include "component_store.h"
 
 #include <stdlib.h>
 
 
-void InitalizeGameObject(GameObject* object)
+typedef struct GameObjectSlot
 {
-	if (object == NULL)
-		return;
-
-	object->Name[0] = '/0';
-	object->CompoentSize = 0;
-	object->Components = NULL;
-
-    object->Parent = NULL;
-
-    object->ChildCount= 0;
-    object->Children = NULL;
-}
-
-GameObject* AddChildObject(GameObject* parent)
+	GameObject Object;
+	unsigned int Generation;
+	bool Alive;
+	int NextFree;
+}GameObjectSlot;
+
+static GameObjectSlot* Slots = NULL;
+static int SlotCount = 0;
+static int SlotCapacity = 0;
+static int FirstFreeSlot = -1;
+
+GameObject* GetGameObject(GameObjectHandle handle)
 {
-	if (parent == NULL)
+	if (handle.Index < 0 || handle.Index >= SlotCount)
 		return NULL;
 
-    parent->ChildCount++;
-    parent->Children = realloc(parent->Children, sizeof(GameObject) * parent->ChildCount);
-    GameObject * object = parent->Children + (parent->ChildCount - 1);
+	GameObjectSlot* slot = Slots + handle.Index;
+	if (!slot->Alive || slot->Generation != handle.Generation)
+		return NULL;
 
-	InitalizeGameObject(object);
+	return &slot->Object;
+}
 
-	return object;
+bool GameObjectHandleIsValid(GameObjectHandle handle)
+{
+	return GetGameObject(handle) != NULL;
 }
 
-void DestoryGameObject(GameObject* object)
+GameObjectHandle CreateGameObject()
 {
-	for (int i = 0; i < object->CompoentSize; i++)
+	int index = FirstFreeSlot;
+	if (index >= 0)
 	{
-		free(object->Components[i].CompValue);
+		FirstFreeSlot = Slots[index].NextFree;
 	}
-	free(object->Components);
-	object->CompoentSize = 0;
-	object->Components = NULL;
+	else
+	{
+		if (SlotCount == SlotCapacity)
+		{
+			SlotCapacity = SlotCapacity == 0 ? 64 : SlotCapacity * 2;
+			Slots = realloc(Slots, sizeof(GameObjectSlot) * SlotCapacity);
+		}
 
-	object->Parent = NULL;
+		index = SlotCount++;
 
-	for (int i = 0; i < object->ChildCount; i++)
-	{
-		DestoryGameObject(object->Children + i);
+		// generations start at 1 so a zeroed handle is never valid
+		Slots[index].Generation = 1;
 	}
 
+	GameObjectSlot* slot = Slots + index;
+	slot->Alive = true;
+	slot->NextFree = -1;
+
+	GameObject* object = &slot->Object;
+	object->Name[0] = '\0';
+	object->Entity = CreateEntity();
+	object->Parent = INVALID_GAME_OBJECT;
 	object->ChildCount = 0;
 	object->Children = NULL;
+
+	return (GameObjectHandle){ index, slot->Generation };
 }
 
-void GameObjectAddComponent(GameObject* object, ComponentType type, void* componentValue)
+GameObjectHandle AddChildObject(GameObjectHandle parent)
 {
-	if (GameObjectHasComponent(object, type))
+	if (!GameObjectHandleIsValid(parent))
+		return INVALID_GAME_OBJECT;
+
+	// creating the child can move the slots, so only look up the parent after
+	GameObjectHandle child = CreateGameObject();
+	GetGameObject(child)->Parent = parent;
+
+	GameObject* parentObject = GetGameObject(parent);
+	parentObject->ChildCount++;
+	parentObject->Children = realloc(parentObject->Children, sizeof(GameObjectHandle) * parentObject->ChildCount);
+	parentObject->Children[parentObject->ChildCount - 1] = child;
+
+	return child;
+}
+
+static void FreeGameObject(GameObjectHandle handle)
+{
+	GameObject* object = GetGameObject(handle);
+	if (object == NULL)
 		return;
 
-	object->CompoentSize++;
-	object->Components = realloc(object->Components, sizeof(GameObjectComponent) * object->CompoentSize);
-	object->Components[object->CompoentSize - 1].CompType = type;
-	object->Components[object->CompoentSize - 1].CompValue = componentValue;
+	for (int i = 0; i < object->ChildCount; i++)
+		FreeGameObject(object->Children[i]);
+
+	DestroyEntity(object->Entity);
+	object->Entity = -1;
+
+	free(object->Children);
+	object->ChildCount = 0;
+	object->Children = NULL;
+
+	// bumping the generation makes every handle to this slot stale
+	GameObjectSlot* slot = Slots + handle.Index;
+	slot->Alive = false;
+	slot->Generation++;
+	slot->NextFree = FirstFreeSlot;
+	FirstFreeSlot = handle.Index;
 }
 
-bool GameObjectHasComponent(GameObject* object, ComponentType type)
+void DestoryGameObject(GameObjectHandle handle)
 {
-	for (int i = 0; i < object->CompoentSize; i++)
+	GameObject* object = GetGameObject(handle);
+	if (object == NULL)
+		return;
+
+	// take it out of its parent's list of children
+	GameObject* parent = GetGameObject(object->Parent);
+	if (parent != NULL)
 	{
-		if (object->Components[i].CompType == type)
-			return true;
+		for (int i = 0; i < parent->ChildCount; i++)
+		{
+			if (parent->Children[i].Index == handle.Index)
+			{
+				parent->Children[i] = parent->Children[parent->ChildCount - 1];
+				parent->ChildCount--;
+				break;
+			}
+		}
 	}
 
-	return false;
+	FreeGameObject(handle);
 }
 
-void* GameObjectGetComponent(GameObject* object, ComponentType type)
+void DestroyAllGameObjects()
 {
-	for (int i = 0; i < object->CompoentSize; i++)
+	for (int i = 0; i < SlotCount; i++)
 	{
-		if (object->Components[i].CompType == type)
-			return object->Components[i].CompValue;
+		if (Slots[i].Alive)
+		{
+			DestroyEntity(Slots[i].Object.Entity);
+			free(Slots[i].Object.Children);
+		}
 	}
 
-	return NULL;
+	free(Slots);
+	Slots = NULL;
+	SlotCount = 0;
+	SlotCapacity = 0;
+	FirstFreeSlot = -1;
+}
+
+void* GameObjectAddComponent(GameObject* object, ComponentType type, const void* componentValue)
+{
+	return AddEntityComponent(object->Entity, type, componentValue);
+}
+
+bool GameObjectHasComponent(GameObject* object, ComponentType type)
+{
+	return (GetEntitySignature(object->Entity) & COMPONENT_BIT(type)) != 0;
+}
+
+void* GameObjectGetComponent(GameObject* object, ComponentType type)
+{
+	return GetEntityComponent(object->Entity, type);
 }
@@ -33,170 +33,199 @@ For a C++ project simply rename the file to .cpp and re-run the build script
 #include "resource_dir.h"	// utility header for SearchAndSetResourceDir
 
 #include "game_object.h"
+#include "component_store.h"
 #include "transform.h"
 #include "sprite.h"
 #include "shape.h"
 #include "behavior.h"
+#include "transform_hierarchy.h"
 
 typedef struct Scene
 {
-	GameObject* Objects;
+	GameObjectHandle* Objects;
 	int ObjectCount;
 }Scene;
 
 Scene TheScene = { 0 };
+TransformHierarchy TheHierarchy = { 0 };
 
 Texture wabbit = { 0 };
 
-void DrawShape(GameObject* object, Transform2D* transform);
-void DrawSprite(GameObject* object, Transform2D* transform);
-void DrawRenderable(GameObject* object);
-
-void UpdateTransform(GameObject* object);
-void UpdateRotation(GameObject* object);
+void DrawShape(GameObject* object, const Transform2D* world);
+void DrawSprite(GameObject* object, const Transform2D* world);
 
 void InitScene()
 {
 	TheScene.ObjectCount = 10;
-	TheScene.Objects = malloc(sizeof(GameObject) * TheScene.ObjectCount);
+	TheScene.Objects = malloc(sizeof(GameObjectHandle) * TheScene.ObjectCount);
 
 	for (int i = 0; i < TheScene.ObjectCount; i++)
-		InitalizeGameObject(TheScene.Objects + i);
+		TheScene.Objects[i] = CreateGameObject();
 
 	for (int index = 0; index < TheScene.ObjectCount; index++)
 	{ 
-		GameObjectAddComponent(TheScene.Objects + index, TransformComponent, CreateTransform());
-		Transform2D* transform = GetTransformComponent(TheScene.Objects + index);
+		GameObject* object = GetGameObject(TheScene.Objects[index]);
+		Transform2D* transform = AddTransformComponent(object);
 		transform->Position.x = (float)GetRandomValue(10, 1200);
 		transform->Position.y = (float)GetRandomValue(10, 700);
 
-		GameObjectAddComponent(TheScene.Objects + index, BehaviorComponent, CreateBahavior(UpdateTransform));
+		AddBehaviorComponent(object, MoveBehavior);
 
 		float radius = (float)GetRandomValue(10, 30);
-		GameObjectAddComponent(TheScene.Objects + index, ShapeComponent, CreateShape(radius));
+		AddShapeComponent(object, radius);
 
         // add a child with sprite
 		
-		GameObject* child = AddChildObject(TheScene.Objects + index);
-        GameObjectAddComponent(child, TransformComponent, CreateTransform());
-        transform = GetTransformComponent(child);
+		GameObject* child = GetGameObject(AddChildObject(TheScene.Objects[index]));
+        transform = AddTransformComponent(child);
 		transform->Position.x = radius * 3;
 		transform->Position.y = 0;
 		transform->Rotation = (float)GetRandomValue(-180, 180);
-		GameObjectAddComponent(child, SpriteComponent, CreateSprite(wabbit));
+		AddSpriteComponent(child, wabbit);
 
-		GameObjectAddComponent(child, BehaviorComponent, CreateBahavior(UpdateRotation));
+		AddBehaviorComponent(child, RotateBehavior);
 	}
+
+	BuildTransformHierarchy(&TheHierarchy, TheScene.Objects, TheScene.ObjectCount);
 }
 
 void DestoryScene()
 {
 	for (int i = 0; i < TheScene.ObjectCount; i++)
-		DestoryGameObject(TheScene.Objects + i);
+		DestoryGameObject(TheScene.Objects[i]);
 
 	free(TheScene.Objects);
 	TheScene.Objects = NULL;
 	TheScene.ObjectCount = 0;
+
+	FreeTransformHierarchy(&TheHierarchy);
+	DestroyAllGameObjects();
+	FreeComponentStore();
 }
 
-void DrawShape(GameObject* object, Transform2D* transform)
+void DrawShape(GameObject* object, const Transform2D* world)
 {
-	rlPushMatrix();
-	rlTranslatef(transform->Position.x, transform->Position.y, 0);
-	rlRotatef(transform->Rotation, 0, 0, 1);
-
 	Shape* shape = GetShapeComponent(object);
-	DrawCircleV(Vector2Zero(), shape->Radius, BLUE);
-	
-	for (int child = 0; child < object->ChildCount; child++)
-		DrawRenderable(object->Children + child);
-	rlPopMatrix();
+	DrawCircleV(world->Position, shape->Radius, BLUE);
 }
 
-void DrawSprite(GameObject* object, Transform2D* transform)
+void DrawSprite(GameObject* object, const Transform2D* world)
 {
-    rlPushMatrix();
-    rlTranslatef(transform->Position.x, transform->Position.y, 0);
-    rlRotatef(transform->Rotation, 0, 0, 1);
-
 	Sprite* sprite = GetSpriteComponent(object);
-	DrawTextureV(sprite->Texture, (Vector2){sprite->Texture.width * 0.5f, sprite->Texture.height * 0.5f }, WHITE);
+	float width = (float)sprite->Texture.width;
+	float height = (float)sprite->Texture.height;
 
-    for (int child = 0; child < object->ChildCount; child++)
-        DrawRenderable(object->Children + child);
-    rlPopMatrix();
+	// offset by half the size in the rotated space, the same place it was drawn with the old matrix stack
+	Rectangle source = { 0, 0, width, height };
+	Rectangle dest = { world->Position.x, world->Position.y, width, height };
+	DrawTexturePro(sprite->Texture, source, dest, (Vector2){ -width * 0.5f, -height * 0.5f }, world->Rotation, WHITE);
 }
 
-void DrawRenderable(GameObject* object)
+void DrawRenderables()
 {
-    Transform2D* transform = GetTransformComponent(object);
-    if (transform == NULL)
-        return;
+	// the hierarchy is in depth first order, so parents still draw before their children
+	for (int node = 0; node < TheHierarchy.Count; node++)
+	{
+		GameObject* object = GetGameObject(TheHierarchy.Objects[node]);
+		if (object == NULL)
+			continue;
+
+		// get the signature once and test it for each kind of renderable
+		ComponentSignature signature = GetEntitySignature(object->Entity);
+		if (!(signature & COMPONENT_BIT(TransformComponent)))
+			continue;
 
-    // shapes
-    if (GameObjectHasComponent(object, ShapeComponent))
-        DrawShape(object, transform);
+		const Transform2D* world = TheHierarchy.World + node;
 
-    // sprites
-    if (GameObjectHasComponent(object, SpriteComponent))
-        DrawSprite(object, transform);
+		// shapes
+		if (signature & COMPONENT_BIT(ShapeComponent))
+			DrawShape(object, world);
+
+		// sprites
+		if (signature & COMPONENT_BIT(SpriteComponent))
+			DrawSprite(object, world);
+	}
 }
 
-void DrawRenderables()
+// behavior systems
+// each one works on a whole column of transforms at once, with no lookups or calls per object
+void UpdateMoveSystem(Transform2D* transforms, int count, float deltaTime)
 {
-	for (int i = 0; i < TheScene.ObjectCount; i++)
+	for (int i = 0; i < count; i++)
 	{
-		DrawRenderable(TheScene.Objects + i);
+		transforms[i].Position.x += deltaTime * 20;
+		transforms[i].Position.y += deltaTime * 10;
 	}
 }
 
-void UpdateTransform(GameObject* object)
+void UpdateRotationSystem(Transform2D* transforms, int count, float deltaTime)
 {
-    Transform2D* transform = GetTransformComponent(object);
-
-    if (transform == NULL)
-        return;
-
-    transform->Position.x += GetFrameTime() * 20;
-    transform->Position.y += GetFrameTime() * 10;
+	for (int i = 0; i < count; i++)
+	{
+		transforms[i].Rotation += deltaTime * 45;
 
-    if (transform->Position.x > 1200)
-        transform->Position.x = 0;
-    if (transform->Position.y > 700)
-        transform->Position.y = 0;
+		// a frame never turns a full circle, so one wrap is enough
+		if (transforms[i].Rotation > 180)
+			transforms[i].Rotation -= 360;
+	}
 }
 
-void UpdateRotation(GameObject* object)
+// in the same order as BehaviorType
+BehaviorSystem BehaviorSystems[BehaviorTypeCount] =
 {
-    Transform2D* transform = GetTransformComponent(object);
+	UpdateMoveSystem,
+	UpdateRotationSystem,
+};
 
-    if (transform == NULL)
-        return;
+typedef struct BehaviorSystemRun
+{
+	BehaviorSystem System;
+	float DeltaTime;
+}BehaviorSystemRun;
 
-	transform->Rotation += GetFrameTime() * 45;
+void RunBehaviorSystem(Archetype* archetype, void* userData)
+{
+	BehaviorSystemRun* run = (BehaviorSystemRun*)userData;
+	run->System((Transform2D*)archetype->Columns[TransformComponent], archetype->Count, run->DeltaTime);
 
-	while (transform->Rotation > 180)
-		transform->Rotation -= 360;
+	MarkTransformsDirty(&TheHierarchy, archetype->Entities, archetype->Count);
 }
 
-void ProcessBehavior(GameObject* object)
+// shapes wrap around the screen, the sprites attached to them are positioned relative to them so they are left alone
+void WrapShapePosition(int entity, void* components[ComponentTypeCount], void* userData)
 {
-    Behavior* behavior = GetBahaviorComponent(object);
+    Transform2D* transform = (Transform2D*)components[TransformComponent];
 
-    if (behavior == NULL)
-        return;
-
-	if (behavior != NULL)
-		behavior->UpdateFunction(object);
+    bool wrapped = false;
+    if (transform->Position.x > 1200)
+    {
+        transform->Position.x = 0;
+        wrapped = true;
+    }
+    if (transform->Position.y > 700)
+    {
+        transform->Position.y = 0;
+        wrapped = true;
+    }
 
-    for (int child = 0; child < object->ChildCount; child++)
-		ProcessBehavior(object->Children + child);
+    if (wrapped)
+        MarkTransformDirty(&TheHierarchy, entity);
 }
 
 void ProcessBehaviors()
 {
-	for (int i = 0; i < TheScene.ObjectCount; i++)
-		ProcessBehavior(TheScene.Objects + i);
+	// each system runs once for every archetype with its behavior and a transform
+	BehaviorSystemRun run = { NULL, GetFrameTime() };
+	for (int type = 0; type < BehaviorTypeCount; type++)
+	{
+		run.System = BehaviorSystems[type];
+		ForEachArchetype(COMPONENT_BIT(TransformComponent) | COMPONENT_BIT(GetBehaviorComponentType((BehaviorType)type)), RunBehaviorSystem, &run);
+	}
+
+	ForEachEntity(COMPONENT_BIT(TransformComponent) | COMPONENT_BIT(ShapeComponent), WrapShapePosition, NULL);
+
+	// only the transforms that changed, and the ones under them, are worked out again
+	UpdateWorldTransforms(&TheHierarchy);
 }
 
 int main ()
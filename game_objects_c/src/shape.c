@@ -2,11 +2,11 @@
 
 #include <stdlib.h>
 
-Shape* CreateShape(float radius)
+Shape* AddShapeComponent(GameObject* object, float radius)
 {
-	Shape* shape = malloc(sizeof(Shape));
-	shape->Radius = radius;
-	return shape;
+	Shape shape = { 0 };
+	shape.Radius = radius;
+	return (Shape*)GameObjectAddComponent(object, ShapeComponent, &shape);
 }
 
 Shape* GetShapeComponent(GameObject* object)
@@ -2,11 +2,11 @@
 
 #include <stdlib.h>
 
-Sprite* CreateSprite(Texture2D texture)
+Sprite* AddSpriteComponent(GameObject* object, Texture2D texture)
 {
-	Sprite* sprite = malloc(sizeof(Sprite));
-	sprite->Texture = texture;
-	return sprite;
+	Sprite sprite = { 0 };
+	sprite.Texture = texture;
+	return (Sprite*)GameObjectAddComponent(object, SpriteComponent, &sprite);
 }
 
 Sprite* GetSpriteComponent(GameObject* object)
@@ -2,12 +2,12 @@
 
 #include <stdlib.h>
 
-Transform2D* CreateTransform()
+Transform2D* AddTransformComponent(GameObject* object)
 {
-	Transform2D* transform = malloc(sizeof(Transform));
-	transform->Position = (Vector2){ 0,0 };
-	transform->Rotation = 0;
-	return transform;
+	Transform2D transform = { 0 };
+	transform.Position = (Vector2){ 0,0 };
+	transform.Rotation = 0;
+	return (Transform2D*)GameObjectAddComponent(object, TransformComponent, &transform);
 }
 
 Transform2D* GetTransformComponent(GameObject* object)
@@ -0,0 +1,135 @@
+#include "transform_hierarchy.h"
+#include "component_store.h"
+
+#include "raymath.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static void AddNode(TransformHierarchy* hierarchy, GameObjectHandle handle, int parent)
+{
+	GameObject* object = GetGameObject(handle);
+	if (object == NULL)
+		return;
+
+	if (hierarchy->Count == hierarchy->Capacity)
+	{
+		hierarchy->Capacity = hierarchy->Capacity == 0 ? 64 : hierarchy->Capacity * 2;
+		hierarchy->Objects = realloc(hierarchy->Objects, sizeof(GameObjectHandle) * hierarchy->Capacity);
+		hierarchy->Entities = realloc(hierarchy->Entities, sizeof(int) * hierarchy->Capacity);
+		hierarchy->Parents = realloc(hierarchy->Parents, sizeof(int) * hierarchy->Capacity);
+		hierarchy->World = realloc(hierarchy->World, sizeof(Transform2D) * hierarchy->Capacity);
+		hierarchy->Dirty = realloc(hierarchy->Dirty, sizeof(bool) * hierarchy->Capacity);
+	}
+
+	int node = hierarchy->Count++;
+	hierarchy->Objects[node] = handle;
+	hierarchy->Entities[node] = object->Entity;
+	hierarchy->Parents[node] = parent;
+	hierarchy->World[node] = (Transform2D){ 0 };
+	hierarchy->Dirty[node] = true;
+
+	// the children go right after their parent, and after each other's children
+	for (int child = 0; child < object->ChildCount; child++)
+		AddNode(hierarchy, object->Children[child], node);
+}
+
+void BuildTransformHierarchy(TransformHierarchy* hierarchy, const GameObjectHandle* roots, int rootCount)
+{
+	hierarchy->Count = 0;
+	for (int root = 0; root < rootCount; root++)
+		AddNode(hierarchy, roots[root], -1);
+
+	// map entities back to their nodes for marking them dirty
+	int maxEntity = -1;
+	for (int node = 0; node < hierarchy->Count; node++)
+	{
+		if (hierarchy->Entities[node] > maxEntity)
+			maxEntity = hierarchy->Entities[node];
+	}
+
+	hierarchy->EntityNodeCount = maxEntity + 1;
+	hierarchy->EntityNodes = realloc(hierarchy->EntityNodes, sizeof(int) * (hierarchy->EntityNodeCount > 0 ? hierarchy->EntityNodeCount : 1));
+	for (int entity = 0; entity < hierarchy->EntityNodeCount; entity++)
+		hierarchy->EntityNodes[entity] = -1;
+
+	for (int node = 0; node < hierarchy->Count; node++)
+	{
+		if (hierarchy->Entities[node] >= 0)
+			hierarchy->EntityNodes[hierarchy->Entities[node]] = node;
+	}
+}
+
+void FreeTransformHierarchy(TransformHierarchy* hierarchy)
+{
+	free(hierarchy->Objects);
+	free(hierarchy->Entities);
+	free(hierarchy->Parents);
+	free(hierarchy->World);
+	free(hierarchy->Dirty);
+	free(hierarchy->EntityNodes);
+	memset(hierarchy, 0, sizeof(TransformHierarchy));
+}
+
+void MarkTransformDirty(TransformHierarchy* hierarchy, int entity)
+{
+	if (entity < 0 || entity >= hierarchy->EntityNodeCount || hierarchy->EntityNodes[entity] < 0)
+		return;
+
+	hierarchy->Dirty[hierarchy->EntityNodes[entity]] = true;
+}
+
+void MarkTransformsDirty(TransformHierarchy* hierarchy, const int* entities, int count)
+{
+	for (int i = 0; i < count; i++)
+		MarkTransformDirty(hierarchy, entities[i]);
+}
+
+void UpdateWorldTransforms(TransformHierarchy* hierarchy)
+{
+	bool anyDirty = false;
+
+	for (int node = 0; node < hierarchy->Count; node++)
+	{
+		int parent = hierarchy->Parents[node];
+
+		// parents come first, so a parent that changed this pass has already been flagged
+		if (parent >= 0 && hierarchy->Dirty[parent])
+			hierarchy->Dirty[node] = true;
+
+		if (!hierarchy->Dirty[node])
+			continue;
+
+		anyDirty = true;
+
+		// objects without a transform sit at their parent's origin
+		Transform2D local = { 0 };
+		Transform2D* component = (Transform2D*)GetEntityComponent(hierarchy->Entities[node], TransformComponent);
+		if (component != NULL)
+			local = *component;
+
+		if (parent < 0)
+		{
+			hierarchy->World[node] = local;
+			continue;
+		}
+
+		// the same as translating to the parent, rotating by it, then translating by the local position
+		const Transform2D* parentWorld = hierarchy->World + parent;
+		Vector2 offset = Vector2Rotate(local.Position, parentWorld->Rotation * DEG2RAD);
+
+		hierarchy->World[node].Position = Vector2Add(parentWorld->Position, offset);
+		hierarchy->World[node].Rotation = parentWorld->Rotation + local.Rotation;
+	}
+
+	if (anyDirty)
+		memset(hierarchy->Dirty, 0, sizeof(bool) * hierarchy->Count);
+}
+
+const Transform2D* GetWorldTransform(const TransformHierarchy* hierarchy, int entity)
+{
+	if (entity < 0 || entity >= hierarchy->EntityNodeCount || hierarchy->EntityNodes[entity] < 0)
+		return NULL;
+
+	return hierarchy->World + hierarchy->EntityNodes[entity];
+}
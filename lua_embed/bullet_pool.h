@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdbool.h>
+
+// a pool of bullet slots with O(1) spawn and despawn
+// the bullets themselves stay in the game's own array, so a slot index is stable for as long as the bullet is alive
+// live slots are kept packed at the front of Live, so updates and drawing only ever visit bullets that are alive
+// free slots are chained together through Links, and a live slot's Links entry is where it sits in Live
+// removing a bullet swaps the last live slot into its place, so the order of Live changes as bullets die
+
+typedef struct BulletPool
+{
+    int Capacity;
+    int Count;
+
+    int* Live;
+    int* Links;
+
+    int FirstFree;
+}BulletPool;
+
+bool InitBulletPool(BulletPool* pool, int capacity);
+void FreeBulletPool(BulletPool* pool);
+
+// returns the slot to use for a new bullet, or -1 if the pool is full
+int SpawnBullet(BulletPool* pool);
+
+// returns the slot to the pool, when called while looping over Live, the same position must be visited again
+void DespawnBullet(BulletPool* pool, int slot);
+
+// frees every slot
+void ClearBulletPool(BulletPool* pool);
@@ -32,6 +32,18 @@
 #include "raylib.h"
 #include "raymath.h"
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bullet_pool.h"
+#include "script_alloc.h"
+#include "script_threads.h"
+#include "script_watch.h"
+#include "sprite_batch.h"
 
 #if defined(__cplusplus)
 extern "C" { // disable name mangling for C++
@@ -66,174 +78,1439 @@ Entity Player = { 0 };
 Entity Enemies[MAX_ENIMIES] = { 0 };
 Bullet Bullets[MAX_BULLETS] = { 0 };
 
+// which bullet slots are alive, spawning and updating bullets only touch these
+BulletPool ActiveBullets = { 0 };
+
+// script commands
+// worker states run at the same time as each other, so they can't change the game directly
+// instead the bound functions and views record what they want to do in a command buffer,
+// and the main thread applies the buffers in worker order once every worker is done, so the result does not depend on thread timing
+typedef enum
+{
+    SetFieldCommand = 0,
+    MoveEnemyCommand = 1,
+    TurnTowardPlayerCommand = 2,
+    EnemyFireCommand = 3,
+}ScriptCommandType;
+
+typedef struct
+{
+    ScriptCommandType Type;
+    int Index;
+    float* Field;
+    float Values[2];
+}ScriptCommand;
+
+typedef struct
+{
+    ScriptCommand* Commands;
+    int Count;
+    int Capacity;
+}ScriptCommandBuffer;
+
+ScriptCommand* AddScriptCommand(ScriptCommandBuffer* buffer, ScriptCommandType type, int index)
+{
+    if (buffer->Count == buffer->Capacity)
+    {
+        buffer->Capacity = buffer->Capacity > 0 ? buffer->Capacity * 2 : 64;
+        buffer->Commands = (ScriptCommand*)realloc(buffer->Commands, sizeof(ScriptCommand) * buffer->Capacity);
+    }
+
+    ScriptCommand* command = &buffer->Commands[buffer->Count++];
+    command->Type = type;
+    command->Index = index;
+    command->Field = NULL;
+    return command;
+}
+
+// script contexts
+// everything the game keeps for a lua state, a pointer to it is stored in the state's extra space so the bound functions can find it
+#define MAX_CACHED_SCRIPTS 16
+#define MAX_SCRIPT_PATH 256
+
+// behaviors run in the fixed time step, and the enemies are split into round robin buckets so each tick only runs one bucket
+// every enemy still thinks at a steady rate (the fixed rate / BEHAVIOR_BUCKETS), but a tick only pays for a fraction of them
+#define BEHAVIOR_BUCKETS 4
+
+typedef struct
+{
+    char File[MAX_SCRIPT_PATH];
+    int ChunkRef;
+}CachedScript;
+
+typedef struct
+{
+    ScriptAllocator Allocator;
+
+    CachedScript ScriptCache[MAX_CACHED_SCRIPTS];
+    int CachedScriptCount;
+
+    double ScriptDeadline;
+
+    // the heap size that starts the next collection cycle, and if one is in progress
+    int GCThresholdKB;
+    bool GCCycleRunning;
+
+    int BatchUpdateRef;
+    int BucketListRefs[BEHAVIOR_BUCKETS];
+
+    // the view tables of the Enemies and Bullets lists, for spatial queries to return views from
+    int EnemyViewsRef;
+    int BulletViewsRef;
+
+    // which share of each bucket this state runs
+    int WorkerIndex;
+    int WorkerCount;
+
+    // NULL for the main state, which changes the game directly
+    ScriptCommandBuffer* Commands;
+}ScriptContext;
+
+ScriptContext* GetScriptContext(lua_State* luaState)
+{
+    return *(ScriptContext**)lua_getextraspace(luaState);
+}
+
 
 // functions bound to lua
 // these are a series of functions that let the lua behavior script get info and change the game state.
 
-int LuaGetEnemyCount(lua_State* luaState)
+int LuaGetEnemyCount(lua_State* luaState)
+{
+    lua_pushinteger(luaState, MAX_ENIMIES);
+    return 1;
+}
+
+int LuaGetEnemyPosX(lua_State* luaState)
+{
+    int index = (int)luaL_checkinteger(luaState, 1);
+    lua_pushnumber(luaState, Enemies[index].Position.x);
+    return 1;
+}
+
+int LuaGetEnemyPosY(lua_State* luaState)
+{
+    int index = (int)luaL_checkinteger(luaState, 1);
+    lua_pushnumber(luaState, Enemies[index].Position.y);
+    return 1;
+}
+
+int LuaMovePlayer(lua_State* luaState)
+{
+    int index = (int)luaL_checkinteger(luaState, 1);
+    float x = (float)luaL_checknumber(luaState, 2);
+    float y = (float)luaL_checknumber(luaState, 3);
+
+    ScriptCommandBuffer* commands = GetScriptContext(luaState)->Commands;
+    if (commands)
+    {
+        ScriptCommand* command = AddScriptCommand(commands, MoveEnemyCommand, index);
+        command->Values[0] = x;
+        command->Values[1] = y;
+        return 0;
+    }
+
+    Enemies[index].Position.x = x;
+    Enemies[index].Position.y = y;
+    return 0;
+}
+
+int LuaGetEnemyAngle(lua_State* luaState)
+{
+    int index = (int)luaL_checkinteger(luaState, 1);
+    lua_pushnumber(luaState, Enemies[index].Angle);
+    return 1;
+}
+
+int LuaDistanceToPlayer(lua_State* luaState)
+{
+    int index = (int)luaL_checkinteger(luaState, 1);
+
+    Vector2 vectorToPlayer = Vector2Subtract(Player.Position, Enemies[index].Position);
+
+    lua_pushnumber(luaState, Vector2Length(vectorToPlayer));
+    return 1;
+}
+
+void TurnEnemyTowardPlayer(int index)
+{
+    Vector2 vectorToPlayer = Vector2Normalize(Vector2Subtract(Player.Position, Enemies[index].Position));
+
+    float angle = atan2f(vectorToPlayer.y, vectorToPlayer.x) * RAD2DEG;
+    Enemies[index].Angle = angle;
+}
+
+int LuaTurnTowardPlayer(lua_State* luaState)
+{
+    int index = (int)luaL_checkinteger(luaState, 1);
+    float speed = (float)luaL_checknumber(luaState, 2);
+
+    ScriptCommandBuffer* commands = GetScriptContext(luaState)->Commands;
+    if (commands)
+        AddScriptCommand(commands, TurnTowardPlayerCommand, index);
+    else
+        TurnEnemyTowardPlayer(index);
+
+    lua_pushboolean(luaState, true);
+    return 1;
+}
+
+int LuaEnemyCanFire(lua_State* luaState)
+{
+    int index = (int)luaL_checkinteger(luaState, 1);
+
+    lua_pushboolean(luaState, Enemies[index].ReloadTime <= 0);
+    return 1;
+}
+
+bool FireEnemyBullet(int index, float speed)
+{
+    bool canFire = false;
+
+    if (Enemies[index].ReloadTime <= 0)
+    {
+        int slot = SpawnBullet(&ActiveBullets);
+        if (slot >= 0)
+        {
+            canFire = true;
+
+            Bullets[slot].Velocity = (Vector2){ cosf(DEG2RAD * Enemies[index].Angle), sinf(DEG2RAD * Enemies[index].Angle) };
+            Bullets[slot].Position = Vector2Add(Enemies[index].Position, Vector2Scale(Bullets[slot].Velocity, 25));
+            Bullets[slot].Velocity = Vector2Scale(Bullets[slot].Velocity, speed);
+            Bullets[slot].Lifetime = 3;
+
+            Enemies[index].ReloadTime = 1;
+        }
+    }
+
+    return canFire;
+}
+
+int LuaEnemyFire(lua_State* luaState)
+{
+    int index = (int)luaL_checkinteger(luaState, 1);
+    float speed = (float)luaL_checknumber(luaState, 2);
+
+    ScriptCommandBuffer* commands = GetScriptContext(luaState)->Commands;
+    if (commands)
+    {
+        // we won't know if there was a free bullet until the command is applied, so answer based on the reload time
+        ScriptCommand* command = AddScriptCommand(commands, EnemyFireCommand, index);
+        command->Values[0] = speed;
+        lua_pushboolean(luaState, Enemies[index].ReloadTime <= 0);
+        return 1;
+    }
+
+    lua_pushboolean(luaState, FireEnemyBullet(index, speed));
+    return 1;
+}
+
+void ApplyScriptCommands(ScriptCommandBuffer* buffer)
+{
+    for (int i = 0; i < buffer->Count; i++)
+    {
+        ScriptCommand* command = &buffer->Commands[i];
+        switch (command->Type)
+        {
+        case SetFieldCommand:
+            *command->Field = command->Values[0];
+            break;
+
+        case MoveEnemyCommand:
+            Enemies[command->Index].Position = (Vector2){ command->Values[0], command->Values[1] };
+            break;
+
+        case TurnTowardPlayerCommand:
+            TurnEnemyTowardPlayer(command->Index);
+            break;
+
+        case EnemyFireCommand:
+            FireEnemyBullet(command->Index, command->Values[0]);
+            break;
+        }
+    }
+
+    buffer->Count = 0;
+}
+
+// object views
+// a view is a small userdata that points at a struct in one of our C arrays, reading and writing fields on it goes straight to the struct
+// this lets scripts work on game state without a C function call per value and without copying anything into lua tables
+// each view type has a table of field names to byte offsets that is built once and bound to its __index and __newindex as an upvalue,
+// so a field access is a hash lookup plus a load or store, with no string compares
+
+typedef struct
+{
+    void* Item;
+    lua_Integer Index; // the index used by the API functions, or -1 for things that are not in an array
+}ObjectView;
+
+typedef struct
+{
+    const char* Name;
+    size_t Offset;
+    bool ReadOnly;
+}ViewField;
+
+// the id field has no storage, it returns the index of the view
+#define VIEW_FIELD_ID SIZE_MAX
+
+// the state field is a table that belongs to the view, for scripts to keep their own per object data in
+#define VIEW_FIELD_STATE (SIZE_MAX - 1)
+
+const ViewField EntityViewFields[] =
+{
+    { "x", offsetof(Entity, Position.x), false },
+    { "y", offsetof(Entity, Position.y), false },
+    { "angle", offsetof(Entity, Angle), false },
+    { "reload", offsetof(Entity, ReloadTime), true },
+    { "id", VIEW_FIELD_ID, true },
+    { "state", VIEW_FIELD_STATE, true },
+};
+
+const ViewField BulletViewFields[] =
+{
+    { "x", offsetof(Bullet, Position.x), false },
+    { "y", offsetof(Bullet, Position.y), false },
+    { "vx", offsetof(Bullet, Velocity.x), false },
+    { "vy", offsetof(Bullet, Velocity.y), false },
+    { "lifetime", offsetof(Bullet, Lifetime), false },
+    { "id", VIEW_FIELD_ID, true },
+    { "state", VIEW_FIELD_STATE, true },
+};
+
+// the field table stores each field as (offset << 1) | readOnly, the id field as -1 and the state field as -2
+int LuaObjectViewIndex(lua_State* luaState)
+{
+    // only views have this metamethod, so argument 1 is always one of ours
+    ObjectView* view = (ObjectView*)lua_touserdata(luaState, 1);
+
+    lua_pushvalue(luaState, 2);
+    if (lua_rawget(luaState, lua_upvalueindex(1)) != LUA_TNUMBER)
+        return 1; // unknown field, leaves nil
+
+    lua_Integer field = lua_tointeger(luaState, -1);
+
+    if (field == -2)
+    {
+        // made the first time it is asked for
+        if (lua_getiuservalue(luaState, 1, 1) != LUA_TTABLE)
+        {
+            lua_pop(luaState, 1);
+            lua_newtable(luaState);
+            lua_pushvalue(luaState, -1);
+            lua_setiuservalue(luaState, 1, 1);
+        }
+    }
+    else if (field < 0)
+        lua_pushinteger(luaState, view->Index);
+    else
+        lua_pushnumber(luaState, *(float*)((char*)view->Item + (size_t)(field >> 1)));
+
+    return 1;
+}
+
+int LuaObjectViewNewIndex(lua_State* luaState)
+{
+    ObjectView* view = (ObjectView*)lua_touserdata(luaState, 1);
+
+    lua_pushvalue(luaState, 2);
+    if (lua_rawget(luaState, lua_upvalueindex(1)) != LUA_TNUMBER)
+        return luaL_error(luaState, "unknown field '%s'", lua_tostring(luaState, 2));
+
+    lua_Integer field = lua_tointeger(luaState, -1);
+    if (field < 0 || (field & 1))
+        return luaL_error(luaState, "field '%s' can not be set", lua_tostring(luaState, 2));
+
+    float* value = (float*)((char*)view->Item + (size_t)(field >> 1));
+
+    // check the new value before recording anything, so a bad assignment can't leave a half built command in the buffer
+    float newValue = (float)luaL_checknumber(luaState, 3);
+
+    ScriptCommandBuffer* commands = GetScriptContext(luaState)->Commands;
+    if (commands)
+    {
+        ScriptCommand* command = AddScriptCommand(commands, SetFieldCommand, (int)view->Index);
+        command->Field = value;
+        command->Values[0] = newValue;
+        return 0;
+    }
+
+    *value = newValue;
+    return 0;
+}
+
+void PushObjectView(lua_State* luaState, const char* typeName, void* item, lua_Integer index)
+{
+    ObjectView* view = (ObjectView*)lua_newuserdatauv(luaState, sizeof(ObjectView), 1);
+    view->Item = item;
+    view->Index = index;
+    luaL_setmetatable(luaState, typeName);
+}
+
+// a list is a view over an array, indexed from 0 like the enemy API functions
+// the views for each element are made once and kept in a table stored with the list, so indexing a list never allocates
+// a list can also be a slice of another list (every Stride'th view starting at First), that shares the same views
+typedef struct
+{
+    int First;
+    int Stride;
+    int Count;
+}ObjectList;
+
+int LuaObjectListIndex(lua_State* luaState)
+{
+    ObjectList* list = (ObjectList*)lua_touserdata(luaState, 1);
+    lua_Integer index = luaL_checkinteger(luaState, 2);
+
+    if (index < 0 || index >= list->Count)
+    {
+        lua_pushnil(luaState);
+        return 1;
+    }
+
+    lua_getiuservalue(luaState, 1, 1);
+    lua_rawgeti(luaState, -1, list->First + index * list->Stride);
+    return 1;
+}
+
+int LuaObjectListLength(lua_State* luaState)
+{
+    ObjectList* list = (ObjectList*)lua_touserdata(luaState, 1);
+    lua_pushinteger(luaState, list->Count);
+    return 1;
+}
+
+void PushObjectList(lua_State* luaState, const char* viewTypeName, void* items, size_t itemSize, int count)
+{
+    ObjectList* list = (ObjectList*)lua_newuserdatauv(luaState, sizeof(ObjectList), 1);
+    list->First = 0;
+    list->Stride = 1;
+    list->Count = count;
+    luaL_setmetatable(luaState, "ObjectList");
+
+    lua_createtable(luaState, count, 0);
+    for (int i = 0; i < count; i++)
+    {
+        PushObjectView(luaState, viewTypeName, (char*)items + itemSize * i, i);
+        lua_rawseti(luaState, -2, i);
+    }
+    lua_setiuservalue(luaState, -2, 1);
+}
+
+// pushes a slice of the list at listIndex that has every stride'th item starting at first
+void PushObjectListSlice(lua_State* luaState, int listIndex, int first, int stride)
+{
+    listIndex = lua_absindex(luaState, listIndex);
+    ObjectList* source = (ObjectList*)luaL_checkudata(luaState, listIndex, "ObjectList");
+
+    ObjectList* list = (ObjectList*)lua_newuserdatauv(luaState, sizeof(ObjectList), 1);
+    list->First = source->First + first * source->Stride;
+    list->Stride = source->Stride * stride;
+    list->Count = first < source->Count ? (source->Count - first + stride - 1) / stride : 0;
+    luaL_setmetatable(luaState, "ObjectList");
+
+    lua_getiuservalue(luaState, listIndex, 1);
+    lua_setiuservalue(luaState, -2, 1);
+}
+
+void DefineViewType(lua_State* luaState, const char* typeName, const ViewField* fields, int fieldCount)
+{
+    luaL_newmetatable(luaState, typeName);
+
+    lua_createtable(luaState, 0, fieldCount);
+    for (int i = 0; i < fieldCount; i++)
+    {
+        if (fields[i].Offset == VIEW_FIELD_ID)
+            lua_pushinteger(luaState, -1);
+        else if (fields[i].Offset == VIEW_FIELD_STATE)
+            lua_pushinteger(luaState, -2);
+        else
+            lua_pushinteger(luaState, (lua_Integer)((fields[i].Offset << 1) | (fields[i].ReadOnly ? 1 : 0)));
+        lua_setfield(luaState, -2, fields[i].Name);
+    }
+
+    // both metamethods share the field table
+    lua_pushvalue(luaState, -1);
+    lua_pushcclosure(luaState, LuaObjectViewIndex, 1);
+    lua_setfield(luaState, -3, "__index");
+    lua_pushcclosure(luaState, LuaObjectViewNewIndex, 1);
+    lua_setfield(luaState, -2, "__newindex");
+
+    lua_pop(luaState, 1);
+}
+
+void PushLuaViewTypes(lua_State* luaState)
+{
+    DefineViewType(luaState, "EntityView", EntityViewFields, sizeof(EntityViewFields) / sizeof(EntityViewFields[0]));
+    DefineViewType(luaState, "BulletView", BulletViewFields, sizeof(BulletViewFields) / sizeof(BulletViewFields[0]));
+
+    luaL_newmetatable(luaState, "ObjectList");
+    lua_pushcfunction(luaState, LuaObjectListIndex);
+    lua_setfield(luaState, -2, "__index");
+    lua_pushcfunction(luaState, LuaObjectListLength);
+    lua_setfield(luaState, -2, "__len");
+    lua_pop(luaState, 1);
+}
+
+// spatial grid
+// enemies and live bullets are put in a uniform grid once per fixed step, so scripts can find things near a point
+// without looping over every enemy themselves. The grid covers the bounds of everything in it and the cell size
+// grows if that would need more than SPATIAL_GRID_MAX_CELLS cells a side, so far away bullets can't blow it up.
+// The items are sorted by cell (a counting sort), so each cell is a contiguous run of item ids and positions.
+#define SPATIAL_CELL_SIZE 64.0f
+#define SPATIAL_GRID_MAX_CELLS 128
+#define SPATIAL_MAX_ITEMS (MAX_ENIMIES + MAX_BULLETS)
+
+// item ids below MAX_ENIMIES are enemies, the rest are bullets
+typedef struct
+{
+    Vector2 Origin;
+    float CellSize;
+    int Columns;
+    int Rows;
+
+    int CellStarts[SPATIAL_GRID_MAX_CELLS * SPATIAL_GRID_MAX_CELLS + 1];
+    int ItemIds[SPATIAL_MAX_ITEMS];
+    Vector2 ItemPositions[SPATIAL_MAX_ITEMS];
+    int ItemCount;
+}SpatialGrid;
+
+SpatialGrid Grid = { 0 };
+
+int GetGridCell(float value, float origin, float cellSize, int cells)
+{
+    int cell = (int)((value - origin) / cellSize);
+    if (cell < 0)
+        return 0;
+    if (cell >= cells)
+        return cells - 1;
+    return cell;
+}
+
+void AddGridItem(int* ids, Vector2* positions, int* count, int id, Vector2 position)
+{
+    ids[*count] = id;
+    positions[*count] = position;
+    (*count)++;
+}
+
+void RebuildSpatialGrid()
+{
+    static int unsortedIds[SPATIAL_MAX_ITEMS];
+    static Vector2 unsortedPositions[SPATIAL_MAX_ITEMS];
+    static int itemCells[SPATIAL_MAX_ITEMS];
+
+    int count = 0;
+    for (int i = 0; i < MAX_ENIMIES; i++)
+        AddGridItem(unsortedIds, unsortedPositions, &count, i, Enemies[i].Position);
+
+    for (int i = 0; i < ActiveBullets.Count; i++)
+    {
+        int slot = ActiveBullets.Live[i];
+        AddGridItem(unsortedIds, unsortedPositions, &count, MAX_ENIMIES + slot, Bullets[slot].Position);
+    }
+
+    // size the grid to fit everything
+    Vector2 min = unsortedPositions[0];
+    Vector2 max = unsortedPositions[0];
+    for (int i = 1; i < count; i++)
+    {
+        min = Vector2Min(min, unsortedPositions[i]);
+        max = Vector2Max(max, unsortedPositions[i]);
+    }
+
+    float largestSide = fmaxf(max.x - min.x, max.y - min.y);
+    Grid.CellSize = fmaxf(SPATIAL_CELL_SIZE, largestSide / (SPATIAL_GRID_MAX_CELLS - 1));
+    Grid.Origin = min;
+    Grid.Columns = (int)fminf((max.x - min.x) / Grid.CellSize + 1, SPATIAL_GRID_MAX_CELLS);
+    Grid.Rows = (int)fminf((max.y - min.y) / Grid.CellSize + 1, SPATIAL_GRID_MAX_CELLS);
+    Grid.ItemCount = count;
+
+    int cellCount = Grid.Columns * Grid.Rows;
+    memset(Grid.CellStarts, 0, sizeof(int) * (cellCount + 1));
+
+    // count the items in each cell, then turn the counts into start offsets
+    for (int i = 0; i < count; i++)
+    {
+        int column = GetGridCell(unsortedPositions[i].x, Grid.Origin.x, Grid.CellSize, Grid.Columns);
+        int row = GetGridCell(unsortedPositions[i].y, Grid.Origin.y, Grid.CellSize, Grid.Rows);
+        itemCells[i] = row * Grid.Columns + column;
+        Grid.CellStarts[itemCells[i] + 1]++;
+    }
+
+    for (int cell = 0; cell < cellCount; cell++)
+        Grid.CellStarts[cell + 1] += Grid.CellStarts[cell];
+
+    // place each item, using the end of each cell's run as a cursor and then putting it back
+    for (int i = 0; i < count; i++)
+    {
+        int slot = Grid.CellStarts[itemCells[i]]++;
+        Grid.ItemIds[slot] = unsortedIds[i];
+        Grid.ItemPositions[slot] = unsortedPositions[i];
+    }
+
+    for (int cell = cellCount; cell > 0; cell--)
+        Grid.CellStarts[cell] = Grid.CellStarts[cell - 1];
+    Grid.CellStarts[0] = 0;
+}
+
+// the state of one QueryRadius loop, this is the invariant state of the generic for, so it's the only thing a query allocates
+typedef struct
+{
+    Vector2 Center;
+    float RadiusSquared;
+
+    int FirstColumn;
+    int LastColumn;
+    int LastRow;
+
+    int Column;
+    int Row;
+    int Item;
+    int CellEnd;
+}SpatialQuery;
+
+// returns the next view in range and "enemy" or "bullet", or nothing when the query is done
+int LuaQueryRadiusNext(lua_State* luaState)
+{
+    SpatialQuery* query = (SpatialQuery*)lua_touserdata(luaState, 1);
+
+    while (query->Row <= query->LastRow)
+    {
+        while (query->Item < query->CellEnd)
+        {
+            int slot = query->Item++;
+            if (Vector2DistanceSqr(Grid.ItemPositions[slot], query->Center) > query->RadiusSquared)
+                continue;
+
+            ScriptContext* context = GetScriptContext(luaState);
+            int id = Grid.ItemIds[slot];
+
+            if (id < MAX_ENIMIES)
+            {
+                lua_rawgeti(luaState, LUA_REGISTRYINDEX, context->EnemyViewsRef);
+                lua_rawgeti(luaState, -1, id);
+                lua_pushliteral(luaState, "enemy");
+            }
+            else
+            {
+                lua_rawgeti(luaState, LUA_REGISTRYINDEX, context->BulletViewsRef);
+                lua_rawgeti(luaState, -1, id - MAX_ENIMIES);
+                lua_pushliteral(luaState, "bullet");
+            }
+            return 2;
+        }
+
+        // move on to the next cell
+        query->Column++;
+        if (query->Column > query->LastColumn)
+        {
+            query->Column = query->FirstColumn;
+            query->Row++;
+            if (query->Row > query->LastRow)
+                break;
+        }
+
+        int cell = query->Row * Grid.Columns + query->Column;
+        query->Item = Grid.CellStarts[cell];
+        query->CellEnd = Grid.CellStarts[cell + 1];
+    }
+
+    return 0;
+}
+
+// QueryRadius(x, y, radius), for use in a generic for, loops over the enemies and bullets within radius of the point
+// positions are as of the start of the current fixed step
+int LuaQueryRadius(lua_State* luaState)
+{
+    float x = (float)luaL_checknumber(luaState, 1);
+    float y = (float)luaL_checknumber(luaState, 2);
+    float radius = (float)luaL_checknumber(luaState, 3);
+
+    lua_pushcfunction(luaState, LuaQueryRadiusNext);
+
+    SpatialQuery* query = (SpatialQuery*)lua_newuserdatauv(luaState, sizeof(SpatialQuery), 0);
+    query->Center = (Vector2){ x, y };
+    query->RadiusSquared = radius * radius;
+    query->FirstColumn = GetGridCell(x - radius, Grid.Origin.x, Grid.CellSize, Grid.Columns);
+    query->LastColumn = GetGridCell(x + radius, Grid.Origin.x, Grid.CellSize, Grid.Columns);
+    query->Row = GetGridCell(y - radius, Grid.Origin.y, Grid.CellSize, Grid.Rows);
+    query->LastRow = GetGridCell(y + radius, Grid.Origin.y, Grid.CellSize, Grid.Rows);
+    query->Column = query->FirstColumn;
+
+    int cell = query->Row * Grid.Columns + query->Column;
+    query->Item = Grid.ItemCount > 0 ? Grid.CellStarts[cell] : 0;
+    query->CellEnd = Grid.ItemCount > 0 ? Grid.CellStarts[cell + 1] : 0;
+    if (Grid.ItemCount == 0)
+        query->Row = query->LastRow + 1;
+
+    lua_pushnil(luaState);
+    return 3;
+}
+
+// loads bound functions into lua state
+void PushLuaAPI(lua_State* luaState)
+{
+    PushLuaViewTypes(luaState);
+
+    PushObjectView(luaState, "EntityView", &Player, -1);
+    lua_setglobal(luaState, "Player");
+
+    ScriptContext* context = GetScriptContext(luaState);
+
+    PushObjectList(luaState, "EntityView", Enemies, sizeof(Entity), MAX_ENIMIES);
+    lua_getiuservalue(luaState, -1, 1);
+    context->EnemyViewsRef = luaL_ref(luaState, LUA_REGISTRYINDEX);
+    lua_setglobal(luaState, "Enemies");
+
+    PushObjectList(luaState, "BulletView", Bullets, sizeof(Bullet), MAX_BULLETS);
+    lua_getiuservalue(luaState, -1, 1);
+    context->BulletViewsRef = luaL_ref(luaState, LUA_REGISTRYINDEX);
+    lua_setglobal(luaState, "Bullets");
+
+    lua_register(luaState, "QueryRadius", LuaQueryRadius);
+
+    lua_register(luaState, "GetEnemyCount", LuaGetEnemyCount);
+    lua_register(luaState, "EnemyFire", LuaEnemyFire);
+    lua_register(luaState, "EnemyCanFire", LuaEnemyCanFire);
+    lua_register(luaState, "GetEnemyPosX", LuaGetEnemyPosX);
+    lua_register(luaState, "GetEnemyPosY", LuaGetEnemyPosY);
+    lua_register(luaState, "GetEnemyAngle", LuaGetEnemyAngle);
+    lua_register(luaState, "MovePlayer", LuaMovePlayer);
+    lua_register(luaState, "DistanceToPlayer", LuaDistanceToPlayer);
+    lua_register(luaState, "TurnTowardPlayer", LuaTurnTowardPlayer);
+}
+
+// script time budgets
+// a count hook checks the clock every SCRIPT_BUDGET_CHECK_INSTRUCTIONS lua instructions and raises an error in any script that has run past its deadline
+// so a slow or stuck script costs at most its budget (plus one check interval) instead of stalling the frame
+#define SCRIPT_BUDGET_CHECK_INSTRUCTIONS 1000
+
+// the clock for script and GC budgets, raylib's GetTime only runs once a window is open, and the benchmarks run without one
+double GetScriptTime()
+{
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1000000000.0;
+}
+
+void LuaBudgetHook(lua_State* luaState, lua_Debug* debugInfo)
+{
+    if (GetScriptTime() > GetScriptContext(luaState)->ScriptDeadline)
+        luaL_error(luaState, "script ran past its time budget");
+}
+
+// calls the function below the arguments on the stack, stopping it if it runs for longer than the budget
+// a budget of 0 means no limit
+bool CallLuaFunction(lua_State* luaState, int argCount, double budgetMicroseconds)
+{
+    ScriptContext* context = GetScriptContext(luaState);
+    context->ScriptDeadline = budgetMicroseconds > 0 ? GetScriptTime() + budgetMicroseconds / 1000000.0 : HUGE_VAL;
+
+    bool ok = lua_pcall(luaState, argCount, 0, 0) == LUA_OK;
+    if (!ok)
+    {
+        TraceLog(LOG_WARNING, "LUA: %s", lua_tostring(luaState, -1));
+        lua_pop(luaState, 1);
+    }
+
+    context->ScriptDeadline = HUGE_VAL;
+    return ok;
+}
+
+// compiled script cache
+// scripts are read and compiled once, and the compiled chunk is kept in the lua registry
+// running a cached script is just a registry lookup and a call, so there is no file IO or parsing in the game loop
+// each lua state has its own cache in its script context
+
+// returns the registry reference to the compiled chunk for a script file, compiling it the first time it is asked for
+// scripts that fail to compile are cached as LUA_REFNIL so we don't hit the disk again every frame
+int LoadLuaScript(lua_State* luaState, const char* scriptFile)
+{
+    if (!scriptFile)
+        return LUA_NOREF;
+
+    ScriptContext* context = GetScriptContext(luaState);
+    for (int i = 0; i < context->CachedScriptCount; i++)
+    {
+        if (strcmp(context->ScriptCache[i].File, scriptFile) == 0)
+            return context->ScriptCache[i].ChunkRef;
+    }
+
+    if (context->CachedScriptCount >= MAX_CACHED_SCRIPTS || strlen(scriptFile) >= MAX_SCRIPT_PATH)
+        return LUA_NOREF;
+
+    int chunkRef = LUA_REFNIL;
+    if (luaL_loadfile(luaState, scriptFile) == LUA_OK)
+    {
+        // luaL_ref pops the compiled function off the stack
+        chunkRef = luaL_ref(luaState, LUA_REGISTRYINDEX);
+    }
+    else
+    {
+        TraceLog(LOG_WARNING, "LUA: %s", lua_tostring(luaState, -1));
+        lua_pop(luaState, 1);
+    }
+
+    CachedScript* cached = &context->ScriptCache[context->CachedScriptCount++];
+    strcpy(cached->File, scriptFile);
+    cached->ChunkRef = chunkRef;
+
+    // does nothing unless hot reload is running
+    WatchScriptFile(scriptFile);
+
+    return chunkRef;
+}
+
+// runs a chunk that was compiled by LoadLuaScript, within a time budget (0 for no limit)
+void RunLuaChunk(lua_State* luaState, int chunkRef, double budgetMicroseconds)
+{
+    if (chunkRef == LUA_NOREF || chunkRef == LUA_REFNIL)
+        return;
+
+    lua_rawgeti(luaState, LUA_REGISTRYINDEX, chunkRef);
+    CallLuaFunction(luaState, 0, budgetMicroseconds);
+}
+
+// runs the file as a lua script, using the cached compiled version if it has been run before
+void RunLuaScript(lua_State* luaState, const char* scriptFile)
+{
+    RunLuaChunk(luaState, LoadLuaScript(luaState, scriptFile), 0);
+}
+
+// releases all the compiled chunks held by the cache
+void UnloadLuaScripts(lua_State* luaState)
+{
+    ScriptContext* context = GetScriptContext(luaState);
+    for (int i = 0; i < context->CachedScriptCount; i++)
+        luaL_unref(luaState, LUA_REGISTRYINDEX, context->ScriptCache[i].ChunkRef);
+
+    context->CachedScriptCount = 0;
+}
+
+Texture PlayerTexture;
+Texture EnemyTexture;
+Texture BulletTexture;
+
+void LoadResources()
+{
+    PlayerTexture = LoadTexture("resources/textures/player.png");
+    EnemyTexture = LoadTexture("resources/textures/enemy.png");
+    BulletTexture = LoadTexture("resources/textures/bullet.png");
+}
+
+void SetupGame()
+{
+    Vector2 centerScreen = { GetScreenWidth() * 0.5f, GetScreenHeight() * 0.5f };
+    Player.Position = centerScreen;
+    Player.Angle = 0;
+
+    for (int i = 0; i < MAX_ENIMIES; i++)
+    {
+        Vector2 randomPos = { (float)GetRandomValue(10,GetScreenWidth() - 10), (float)GetRandomValue(10,GetScreenHeight() - 10) };
+        Enemies[i].Position = randomPos;
+        Enemies[i].Angle = (float)GetRandomValue(-180, 180);
+        Enemies[i].ReloadTime = 0;
+    }
+}
+
+// enemy behaviors can run three ways
+// the per enemy script is run once for every enemy, with CurrentEnemy set to the enemy's index
+// the batch script is run once at startup to define update(enemies, dt), and that function is called with a list of enemies
+// the coroutine script is run once at startup to define behavior(enemy), and each enemy runs that in its own coroutine
+#define ENEMY_BEHAVIOR_SCRIPT "resources/scripts/enemy_behavior.lua"
+#define ENEMY_UPDATE_SCRIPT "resources/scripts/enemy_update.lua"
+#define ENEMY_COROUTINE_SCRIPT "resources/scripts/enemy_coroutine.lua"
+
+typedef enum
+{
+    PerEnemyBehaviors = 0,
+    BatchBehaviors = 1,
+    CoroutineBehaviors = 2,
+}BehaviorMode;
+
+const char* BehaviorModeNames[] = { "Per Enemy", "Batch", "Coroutine" };
+
+// how long one run of a behavior script may take, the per enemy script gets this for each enemy, the batch script for each bucket
+#define ENEMY_SCRIPT_BUDGET_US 250.0
+#define BATCH_SCRIPT_BUDGET_US 2000.0
+
+BehaviorMode CurrentBehaviorMode = BatchBehaviors;
+int BehaviorTick = 0;
+
+// loads the batch script, and makes the enemy lists we pass to it
+// runs the batch script (again, if it was reloaded) and keeps a reference to the update function it defines
+void BindBatchUpdate(lua_State* luaState)
+{
+    ScriptContext* context = GetScriptContext(luaState);
+
+    luaL_unref(luaState, LUA_REGISTRYINDEX, context->BatchUpdateRef);
+    context->BatchUpdateRef = LUA_NOREF;
+
+    lua_pushnil(luaState);
+    lua_setglobal(luaState, "update");
+
+    RunLuaScript(luaState, ENEMY_UPDATE_SCRIPT);
+
+    if (lua_getglobal(luaState, "update") == LUA_TFUNCTION)
+    {
+        context->BatchUpdateRef = luaL_ref(luaState, LUA_REGISTRYINDEX);
+    }
+    else
+    {
+        lua_pop(luaState, 1);
+        TraceLog(LOG_WARNING, "LUA: %s does not define update(enemies, dt), using per enemy behaviors", ENEMY_UPDATE_SCRIPT);
+    }
+}
+
+void LoadBatchBehaviors(lua_State* luaState)
+{
+    ScriptContext* context = GetScriptContext(luaState);
+
+    BindBatchUpdate(luaState);
+
+    // one list per bucket, all sharing the same enemy views, and holding only this state's share of the bucket
+    lua_getglobal(luaState, "Enemies");
+    for (int bucket = 0; bucket < BEHAVIOR_BUCKETS; bucket++)
+    {
+        PushObjectListSlice(luaState, -1, bucket, BEHAVIOR_BUCKETS);
+        PushObjectListSlice(luaState, -1, context->WorkerIndex, context->WorkerCount);
+        context->BucketListRefs[bucket] = luaL_ref(luaState, LUA_REGISTRYINDEX);
+        lua_pop(luaState, 1);
+    }
+    lua_pop(luaState, 1);
+}
+
+void DoBatchEnemyBehaviors(lua_State* luaState, int bucket, float dt)
+{
+    ScriptContext* context = GetScriptContext(luaState);
+
+    // the first enemy this state would run, if it's past the end there is nothing for us in this bucket
+    if (bucket + context->WorkerIndex * BEHAVIOR_BUCKETS >= MAX_ENIMIES)
+        return;
+
+    lua_rawgeti(luaState, LUA_REGISTRYINDEX, context->BatchUpdateRef);
+    lua_rawgeti(luaState, LUA_REGISTRYINDEX, context->BucketListRefs[bucket]);
+    lua_pushnumber(luaState, dt);
+
+    CallLuaFunction(luaState, 2, BATCH_SCRIPT_BUDGET_US);
+}
+
+// runs the behaviors for this state's share of one bucket of enemies
+// dt is the time since this bucket last ran
+void DoEnemyBehaviors(lua_State* luaState, int bucket, float dt)
+{
+    ScriptContext* context = GetScriptContext(luaState);
+
+    if (CurrentBehaviorMode == BatchBehaviors && context->BatchUpdateRef != LUA_NOREF)
+    {
+        DoBatchEnemyBehaviors(luaState, bucket, dt);
+        return;
+    }
+
+    // look the script up once, every enemy runs the same compiled chunk
+    int behaviorChunk = LoadLuaScript(luaState, ENEMY_BEHAVIOR_SCRIPT);
+
+    int first = bucket + context->WorkerIndex * BEHAVIOR_BUCKETS;
+    int stride = BEHAVIOR_BUCKETS * context->WorkerCount;
+    for (int i = first; i < MAX_ENIMIES; i += stride)
+    {
+        lua_pushinteger(luaState, (lua_Integer)i);
+        lua_setglobal(luaState, "CurrentEnemy");
+
+        RunLuaChunk(luaState, behaviorChunk, ENEMY_SCRIPT_BUDGET_US);
+    }
+}
+
+// coroutine behaviors
+// each enemy owns a lua thread running behavior(enemy), that can pause itself with wait(seconds) or wait_until(condition)
+// a paused enemy sits in a timer wheel keyed by the tick it should wake on, and is not touched again until that slot comes up
+// the wheel covers WAKE_WHEEL_SIZE ticks, longer waits just go around the wheel more than once
+
+#define WAKE_WHEEL_SIZE 64
+
+typedef struct
+{
+    lua_State* Thread;
+    int ThreadRef;
+    int WakeTick;
+    int NextInSlot; // next task in the same wheel slot, or -1
+    bool Started;
+}BehaviorTask;
+
+BehaviorTask BehaviorTasks[MAX_ENIMIES] = { 0 };
+lua_State* BehaviorTaskState = NULL; // the state the task threads (and their registry refs) belong to
+int WakeWheel[WAKE_WHEEL_SIZE] = { 0 };
+int WheelTick = 0;
+
+void ScheduleBehaviorTask(int task, int wakeTick)
+{
+    int slot = wakeTick % WAKE_WHEEL_SIZE;
+
+    BehaviorTasks[task].WakeTick = wakeTick;
+    BehaviorTasks[task].NextInSlot = WakeWheel[slot];
+    WakeWheel[slot] = task;
+}
+
+// wait(seconds), pauses the calling behavior for at least that long
+int LuaWait(lua_State* luaState)
+{
+    luaL_checknumber(luaState, 1);
+    lua_settop(luaState, 1);
+    return lua_yield(luaState, 1);
+}
+
+// wait_until(condition), pauses the calling behavior until the condition function returns true, checking once per tick
+int LuaWaitUntilContinue(lua_State* luaState, int status, lua_KContext context)
+{
+    lua_settop(luaState, 1);
+    lua_pushvalue(luaState, 1);
+    lua_call(luaState, 0, 1);
+
+    if (lua_toboolean(luaState, -1))
+        return 0;
+
+    // yielding 0 seconds wakes us again on the next tick
+    lua_settop(luaState, 1);
+    lua_pushnumber(luaState, 0);
+    return lua_yieldk(luaState, 1, 0, LuaWaitUntilContinue);
+}
+
+int LuaWaitUntil(lua_State* luaState)
+{
+    luaL_checktype(luaState, 1, LUA_TFUNCTION);
+    return LuaWaitUntilContinue(luaState, LUA_OK, 0);
+}
+
+void UnloadCoroutineBehaviors(lua_State* luaState)
+{
+    for (int i = 0; i < MAX_ENIMIES; i++)
+    {
+        if (BehaviorTasks[i].Thread == NULL)
+            continue;
+
+        // a ref is only valid in the registry of the state that made it
+        if (luaState == BehaviorTaskState)
+            luaL_unref(luaState, LUA_REGISTRYINDEX, BehaviorTasks[i].ThreadRef);
+        BehaviorTasks[i].Thread = NULL;
+    }
+
+    for (int slot = 0; slot < WAKE_WHEEL_SIZE; slot++)
+        WakeWheel[slot] = -1;
+
+    BehaviorTaskState = NULL;
+}
+
+// runs the coroutine script and creates a thread for each enemy that will run the behavior function it defines
+// when the script is reloaded this is called again, and every enemy starts over with the new behavior
+void LoadCoroutineBehaviors(lua_State* luaState)
 {
-    lua_pushinteger(luaState, MAX_ENIMIES);
-    return 1;
+    UnloadCoroutineBehaviors(luaState);
+
+    lua_register(luaState, "wait", LuaWait);
+    lua_register(luaState, "wait_until", LuaWaitUntil);
+
+    lua_pushnil(luaState);
+    lua_setglobal(luaState, "behavior");
+
+    RunLuaScript(luaState, ENEMY_COROUTINE_SCRIPT);
+
+    if (lua_getglobal(luaState, "behavior") != LUA_TFUNCTION)
+    {
+        lua_pop(luaState, 1);
+        TraceLog(LOG_WARNING, "LUA: %s does not define behavior(enemy), coroutine behaviors are disabled", ENEMY_COROUTINE_SCRIPT);
+        return;
+    }
+
+    // the enemy views to pass to each behavior
+    lua_getglobal(luaState, "Enemies");
+    lua_getiuservalue(luaState, -1, 1);
+
+    BehaviorTaskState = luaState;
+    for (int i = 0; i < MAX_ENIMIES; i++)
+    {
+        BehaviorTask* task = &BehaviorTasks[i];
+        task->Thread = lua_newthread(luaState);
+        task->ThreadRef = luaL_ref(luaState, LUA_REGISTRYINDEX);
+        task->Started = false;
+
+        // the first resume calls behavior(enemy)
+        lua_pushvalue(luaState, -3);
+        lua_rawgeti(luaState, -2, i);
+        lua_xmove(luaState, task->Thread, 2);
+
+        ScheduleBehaviorTask(i, WheelTick);
+    }
+
+    lua_pop(luaState, 3);
 }
 
-int LuaGetEnemyPosX(lua_State* luaState)
+// resumes a task and puts it back in the wheel if it paused itself
+void ResumeBehaviorTask(lua_State* luaState, int taskIndex, float dt)
 {
-    int index = (int)luaL_checkinteger(luaState, 1);
-    lua_pushnumber(luaState, Enemies[index].Position.x);
-    return 1;
+    BehaviorTask* task = &BehaviorTasks[taskIndex];
+
+    int argCount = task->Started ? 0 : 1;
+    task->Started = true;
+
+    ScriptContext* context = GetScriptContext(luaState);
+
+    int resultCount = 0;
+    context->ScriptDeadline = GetScriptTime() + ENEMY_SCRIPT_BUDGET_US / 1000000.0;
+    int status = lua_resume(task->Thread, luaState, argCount, &resultCount);
+    context->ScriptDeadline = HUGE_VAL;
+
+    if (status == LUA_YIELD)
+    {
+        // whatever was yielded is how long to sleep for, a plain yield is no time, we always wait at least until the next tick
+        double seconds = resultCount > 0 ? lua_tonumber(task->Thread, -1) : 0;
+        lua_pop(task->Thread, resultCount);
+
+        int ticks = (int)ceil(seconds / dt);
+        ScheduleBehaviorTask(taskIndex, WheelTick + (ticks > 1 ? ticks : 1));
+    }
+    else if (status != LUA_OK)
+    {
+        // the behavior errored (or went over its budget), that enemy just stops thinking
+        TraceLog(LOG_WARNING, "LUA: %s", lua_tostring(task->Thread, -1));
+        lua_closethread(task->Thread, luaState);
+    }
 }
 
-int LuaGetEnemyPosY(lua_State* luaState)
+void DoCoroutineBehaviors(lua_State* luaState, float dt)
 {
-    int index = (int)luaL_checkinteger(luaState, 1);
-    lua_pushnumber(luaState, Enemies[index].Position.y);
-    return 1;
+    int slot = WheelTick % WAKE_WHEEL_SIZE;
+
+    // take the whole slot, tasks that are not due yet go back in for their next lap around the wheel
+    int task = WakeWheel[slot];
+    WakeWheel[slot] = -1;
+
+    while (task >= 0)
+    {
+        int next = BehaviorTasks[task].NextInSlot;
+
+        if (BehaviorTasks[task].WakeTick <= WheelTick)
+            ResumeBehaviorTask(luaState, task, dt);
+        else
+            ScheduleBehaviorTask(task, BehaviorTasks[task].WakeTick);
+
+        task = next;
+    }
+
+    WheelTick++;
 }
 
-int LuaMovePlayer(lua_State* luaState)
+// when true new lua states use the pooled allocator in script_alloc.c, otherwise they use the C runtime like luaL_newstate does
+bool UsePoolAllocator = true;
+
+int LuaPanic(lua_State* luaState)
 {
-    int index = (int)luaL_checkinteger(luaState, 1);
-    Enemies[index].Position.x = (float)luaL_checknumber(luaState, 2);
-    Enemies[index].Position.y = (float)luaL_checknumber(luaState, 3);
+    TraceLog(LOG_ERROR, "LUA: unprotected error in call to Lua API (%s)", lua_tostring(luaState, -1));
     return 0;
 }
 
-int LuaGetEnemyAngle(lua_State* luaState)
+// garbage collection
+// the collector never runs on its own, it is stopped when a state is made and stepped once a frame after EndDrawing
+// so collection work happens at the same point every frame and is limited to GC_FRAME_BUDGET_US,
+// instead of landing on whatever script happened to allocate when the debt ran out
+#define GC_FRAME_BUDGET_US 500.0
+#define GC_STEP_KB 16
+
+// like lua's own pause setting, a new cycle doesn't start until the heap has grown by this percent since the last one finished
+#define GC_PAUSE_PERCENT 200
+
+// if a heap gets this big the frame steps are not keeping up, so it gets a full collection
+#define GC_HEAP_LIMIT_KB (64 * 1024)
+
+typedef enum
 {
-    int index = (int)luaL_checkinteger(luaState, 1);
-    lua_pushnumber(luaState, Enemies[index].Angle);
-    return 1;
+    IncrementalGC = 0,
+    GenerationalGC = 1,
+}ScriptGCMode;
+
+const char* ScriptGCModeNames[] = { "Incremental", "Generational" };
+
+typedef struct
+{
+    double FrameTime; // time spent collecting after the last frame
+    double WorstFrameTime;
+    int HeapKB;
+    int Cycles;
+}ScriptGCStats;
+
+ScriptGCMode CurrentGCMode = IncrementalGC;
+ScriptGCStats GCStats = { 0 };
+
+void SetScriptGCMode(lua_State* luaState, ScriptGCMode mode)
+{
+    // 0 keeps lua's default tuning for the mode
+    if (mode == GenerationalGC)
+        lua_gc(luaState, LUA_GCGEN, 0, 0);
+    else
+        lua_gc(luaState, LUA_GCINC, 0, 0, 0);
+
+    lua_gc(luaState, LUA_GCSTOP);
 }
 
-int LuaDistanceToPlayer(lua_State* luaState)
+// steps the collector for a state until it finishes a cycle or uses up the budget
+// in generational mode each step is a whole minor collection, and lua never reports it as the end of a cycle,
+// so one step counts as a finished cycle and the state waits for the heap to grow again before the next one
+void StepScriptGC(lua_State* luaState, double budgetMicroseconds)
 {
-    int index = (int)luaL_checkinteger(luaState, 1);
+    ScriptContext* context = GetScriptContext(luaState);
+    int heapKB = lua_gc(luaState, LUA_GCCOUNT);
 
-    Vector2 vectorToPlayer = Vector2Subtract(Player.Position, Enemies[index].Position);
+    if (heapKB > GC_HEAP_LIMIT_KB)
+    {
+        lua_gc(luaState, LUA_GCCOLLECT);
+        context->GCCycleRunning = false;
+        context->GCThresholdKB = lua_gc(luaState, LUA_GCCOUNT) * GC_PAUSE_PERCENT / 100;
+        GCStats.Cycles++;
+        return;
+    }
 
-    lua_pushnumber(luaState, Vector2Length(vectorToPlayer));
-    return 1;
+    if (!context->GCCycleRunning && heapKB < context->GCThresholdKB)
+        return;
+
+    context->GCCycleRunning = true;
+
+    double start = GetScriptTime();
+    do
+    {
+        if (lua_gc(luaState, LUA_GCSTEP, GC_STEP_KB) || CurrentGCMode == GenerationalGC)
+        {
+            context->GCCycleRunning = false;
+            context->GCThresholdKB = lua_gc(luaState, LUA_GCCOUNT) * GC_PAUSE_PERCENT / 100;
+            GCStats.Cycles++;
+            break;
+        }
+    } while ((GetScriptTime() - start) * 1000000.0 < budgetMicroseconds);
 }
 
-int LuaTurnTowardPlayer(lua_State* luaState)
+// makes a lua state with the game API and the batch behaviors loaded, that uses the given context
+lua_State* CreateScriptState(ScriptContext* context, int workerIndex, int workerCount, ScriptCommandBuffer* commands)
 {
-    int index = (int)luaL_checkinteger(luaState, 1);
-    float speed = (float)luaL_checknumber(luaState, 2);
+    memset(context, 0, sizeof(ScriptContext));
+    InitScriptAllocator(&context->Allocator, UsePoolAllocator);
+    context->ScriptDeadline = HUGE_VAL;
+    context->BatchUpdateRef = LUA_NOREF;
+    context->WorkerIndex = workerIndex;
+    context->WorkerCount = workerCount;
+    context->Commands = commands;
 
-    Vector2 vectorToPlayer = Vector2Normalize(Vector2Subtract(Player.Position, Enemies[index].Position));
+    // setup our lua state/context
+    lua_State* luaState = lua_newstate(ScriptAlloc, &context->Allocator);
+    lua_atpanic(luaState, LuaPanic);
+    *(ScriptContext**)lua_getextraspace(luaState) = context;
+    luaL_openlibs(luaState);
 
-    float angle = atan2f(vectorToPlayer.y, vectorToPlayer.x) * RAD2DEG;
-    Enemies[index].Angle = angle;
+    // push our exposed API functions into lua
+    PushLuaAPI(luaState);
 
-    lua_pushboolean(luaState, true);
-    return 1;
+    // check the clock every so often while a script is running so we can stop ones that go over their budget
+    lua_sethook(luaState, LuaBudgetHook, LUA_MASKCOUNT, SCRIPT_BUDGET_CHECK_INSTRUCTIONS);
+
+    LoadBatchBehaviors(luaState);
+
+    SetScriptGCMode(luaState, CurrentGCMode);
+
+    return luaState;
 }
 
-int LuaEnemyCanFire(lua_State* luaState)
+void DestroyScriptState(lua_State* luaState)
 {
-    int index = (int)luaL_checkinteger(luaState, 1);
+    ScriptContext* context = GetScriptContext(luaState);
 
-    lua_pushboolean(luaState, Enemies[index].ReloadTime <= 0);
-    return 1;
+    // the behavior tasks hold refs into this state, drop them before it goes away
+    if (BehaviorTaskState == luaState)
+        UnloadCoroutineBehaviors(luaState);
+
+    UnloadLuaScripts(luaState);
+    lua_close(luaState);
+
+    FreeScriptAllocator(&context->Allocator);
 }
 
-int LuaEnemyFire(lua_State* luaState)
+// script workers
+// when there is more than one core, the per enemy and batch behaviors are run by a pool of worker threads, each with its own lua state
+// each worker runs an even share of the bucket, nothing changes the game while they run so they all see the same state,
+// and what they want to change is recorded in their command buffer and applied after they are all done
+#define MAX_SCRIPT_WORKERS 16
+
+typedef struct
 {
-    int index = (int)luaL_checkinteger(luaState, 1);
-    float speed = (float)luaL_checknumber(luaState, 2);
+    lua_State* State;
+    ScriptContext Context;
+    ScriptCommandBuffer Commands;
+}ScriptWorker;
 
-    bool canFire = false;
+ScriptWorker ScriptWorkers[MAX_SCRIPT_WORKERS] = { 0 };
+int ScriptWorkerCount = 0;
+bool UseScriptWorkers = true;
 
-    if (Enemies[index].ReloadTime <= 0)
+int WorkerBucket = 0;
+float WorkerDeltaTime = 0;
+
+void RunScriptWorker(int workerIndex, void* userData)
+{
+    DoEnemyBehaviors(ScriptWorkers[workerIndex].State, WorkerBucket, WorkerDeltaTime);
+}
+
+void StartScriptWorkers()
+{
+    int workerCount = GetProcessorCount();
+    if (workerCount > MAX_SCRIPT_WORKERS)
+        workerCount = MAX_SCRIPT_WORKERS;
+
+    if (workerCount < 2)
+        return;
+
+    for (int i = 0; i < workerCount; i++)
+        ScriptWorkers[i].State = CreateScriptState(&ScriptWorkers[i].Context, i, workerCount, &ScriptWorkers[i].Commands);
+
+    // every state was made to run a 1 / workerCount share of the enemies, so a pool with fewer threads would leave some
+    // enemies never updated, in that case run the scripts on the main thread instead
+    int started = StartWorkerPool(workerCount, RunScriptWorker, NULL);
+    if (started == workerCount)
     {
-        int slot = -1;
-        // find an empty bullet slot
-        for (int i = 0; i < MAX_BULLETS; i++)
-        {
-            if (Bullets[i].Lifetime <= 0)
-            {
-                slot = i;
-                break;
-            }
-        }
+        ScriptWorkerCount = workerCount;
+        return;
+    }
 
-        if (slot >= 0)
-        {
-            canFire = true;
+    if (started > 0)
+    {
+        TraceLog(LOG_WARNING, "LUA: only %d of %d script worker threads started, running scripts on the main thread", started, workerCount);
+        StopWorkerPool();
+    }
 
-            Bullets[slot].Velocity = (Vector2){ cosf(DEG2RAD * Enemies[index].Angle), sinf(DEG2RAD * Enemies[index].Angle) };
-            Bullets[slot].Position = Vector2Add(Enemies[index].Position, Vector2Scale(Bullets[slot].Velocity, 25));
-            Bullets[slot].Velocity = Vector2Scale(Bullets[slot].Velocity, speed);
-            Bullets[slot].Lifetime = 3;
+    for (int i = 0; i < workerCount; i++)
+    {
+        DestroyScriptState(ScriptWorkers[i].State);
+        free(ScriptWorkers[i].Commands.Commands);
+        ScriptWorkers[i].Commands = (ScriptCommandBuffer){ 0 };
+    }
+}
 
-            Enemies[index].ReloadTime = 1;
-        }
+void StopScriptWorkers()
+{
+    StopWorkerPool();
+
+    for (int i = 0; i < ScriptWorkerCount; i++)
+    {
+        DestroyScriptState(ScriptWorkers[i].State);
+        free(ScriptWorkers[i].Commands.Commands);
     }
 
-    lua_pushboolean(luaState, canFire);
-    return 1;
+    ScriptWorkerCount = 0;
 }
 
-// loads bound functions into lua state
-void PushLuaAPI(lua_State* luaState)
+void DoParallelEnemyBehaviors(int bucket, float dt)
 {
-    lua_register(luaState, "GetEnemyCount", LuaGetEnemyCount);
-    lua_register(luaState, "EnemyFire", LuaEnemyFire);
-    lua_register(luaState, "EnemyCanFire", LuaEnemyCanFire);
-    lua_register(luaState, "GetEnemyPosX", LuaGetEnemyPosX);
-    lua_register(luaState, "GetEnemyPosY", LuaGetEnemyPosY);
-    lua_register(luaState, "GetEnemyAngle", LuaGetEnemyAngle);
-    lua_register(luaState, "MovePlayer", LuaMovePlayer);
-    lua_register(luaState, "DistanceToPlayer", LuaDistanceToPlayer);
-    lua_register(luaState, "TurnTowardPlayer", LuaTurnTowardPlayer);
+    WorkerBucket = bucket;
+    WorkerDeltaTime = dt;
+
+    RunWorkerPool();
+
+    // apply in worker order so the result is the same every run
+    for (int i = 0; i < ScriptWorkerCount; i++)
+        ApplyScriptCommands(&ScriptWorkers[i].Commands);
 }
 
-// runs the file as a lua script
-void RunLuaScript(lua_State* luaState, const char* scriptFile)
+// steps the collector for every script state, the workers are idle between fixed steps so this is safe to do from the main thread
+void CollectScriptGarbage(lua_State* mainState)
 {
-    if (!scriptFile)
-        return;
+    double start = GetScriptTime();
+    double budget = GC_FRAME_BUDGET_US / (ScriptWorkerCount + 1);
+
+    StepScriptGC(mainState, budget);
+    GCStats.HeapKB = lua_gc(mainState, LUA_GCCOUNT);
 
-    if (luaL_dofile(luaState, scriptFile) != LUA_OK)
+    for (int i = 0; i < ScriptWorkerCount; i++)
     {
-	lua_pop(luaState, 1);
+        StepScriptGC(ScriptWorkers[i].State, budget);
+        GCStats.HeapKB += lua_gc(ScriptWorkers[i].State, LUA_GCCOUNT);
     }
-}
 
-Texture PlayerTexture;
-Texture EnemyTexture;
-Texture BulletTexture;
+    GCStats.FrameTime = GetScriptTime() - start;
+    if (GCStats.FrameTime > GCStats.WorstFrameTime)
+        GCStats.WorstFrameTime = GCStats.FrameTime;
+}
 
-void LoadResources()
+void SetAllScriptGCModes(lua_State* mainState, ScriptGCMode mode)
 {
-    PlayerTexture = LoadTexture("resources/textures/player.png");
-    EnemyTexture = LoadTexture("resources/textures/enemy.png");
-    BulletTexture = LoadTexture("resources/textures/bullet.png");
+    CurrentGCMode = mode;
+    GCStats.WorstFrameTime = 0;
+
+    SetScriptGCMode(mainState, mode);
+    for (int i = 0; i < ScriptWorkerCount; i++)
+        SetScriptGCMode(ScriptWorkers[i].State, mode);
 }
 
-void SetupGame()
+// hot reload
+// in debug builds the scripts folder is watched, and changed scripts are recompiled on a background thread (see script_watch.c)
+// at the start of a frame the new bytecode is swapped into the cache of every state that uses it, and scripts that define
+// functions are run again so their new definitions are picked up. Views are never remade, so anything a script keeps in
+// enemy.state survives a reload. Release builds never touch the disk after startup.
+#if !defined(NDEBUG)
+#define SCRIPT_HOT_RELOAD
+#endif
+
+#define SCRIPT_FOLDER "resources/scripts"
+
+// swaps a recompiled chunk into a state's script cache, returns false if the state doesn't use that script
+bool ReplaceCachedScript(lua_State* luaState, const CompiledScript* script)
 {
-    Vector2 centerScreen = { GetScreenWidth() * 0.5f, GetScreenHeight() * 0.5f };
-    Player.Position = centerScreen;
-    Player.Angle = 0;
+    ScriptContext* context = GetScriptContext(luaState);
 
-    for (int i = 0; i < MAX_ENIMIES; i++)
+    for (int i = 0; i < context->CachedScriptCount; i++)
     {
-        Vector2 randomPos = { (float)GetRandomValue(10,GetScreenWidth() - 10), (float)GetRandomValue(10,GetScreenHeight() - 10) };
-        Enemies[i].Position = randomPos;
-        Enemies[i].Angle = (float)GetRandomValue(-180, 180);
-        Enemies[i].ReloadTime = 0;
+        CachedScript* cached = &context->ScriptCache[i];
+        if (strcmp(cached->File, script->File) != 0)
+            continue;
+
+        // named the same way luaL_loadfile names chunks, so errors still point at the file
+        if (luaL_loadbufferx(luaState, script->Bytecode, script->Size, TextFormat("@%s", script->File), "b") != LUA_OK)
+        {
+            TraceLog(LOG_WARNING, "LUA: %s", lua_tostring(luaState, -1));
+            lua_pop(luaState, 1);
+            return false;
+        }
+
+        luaL_unref(luaState, LUA_REGISTRYINDEX, cached->ChunkRef);
+        cached->ChunkRef = luaL_ref(luaState, LUA_REGISTRYINDEX);
+        return true;
     }
+
+    return false;
 }
 
-void DoEnemyBehaviors(lua_State* luaState)
+void ReloadScript(lua_State* luaState, const CompiledScript* script, bool mainState)
 {
-    for (int i = 0; i < MAX_ENIMIES; i++)
+    if (!ReplaceCachedScript(luaState, script))
+        return;
+
+    if (strcmp(script->File, ENEMY_UPDATE_SCRIPT) == 0)
+        BindBatchUpdate(luaState);
+
+    // only the main state runs coroutine behaviors
+    if (mainState && strcmp(script->File, ENEMY_COROUTINE_SCRIPT) == 0)
+        LoadCoroutineBehaviors(luaState);
+}
+
+// swaps in any scripts that have been recompiled since the last frame, this must be called between fixed steps
+void ApplyScriptReloads(lua_State* mainState)
+{
+    CompiledScript script;
+    while (PollCompiledScript(&script))
     {
-        lua_pushinteger(luaState, (lua_Integer)i);
-        lua_setglobal(luaState, "CurrentEnemy");
+        TraceLog(LOG_INFO, "LUA: reloading %s", script.File);
 
-        RunLuaScript(luaState, "resources/scripts/enemy_behavior.lua");
+        ReloadScript(mainState, &script, true);
+        for (int i = 0; i < ScriptWorkerCount; i++)
+            ReloadScript(ScriptWorkers[i].State, &script, false);
+
+        free(script.Bytecode);
     }
 }
 
@@ -266,6 +1543,47 @@ void DrawEntity(Vector2 position, float angle, Texture2D sprite, Color tint)
     DrawTexturePro(sprite, sourceRect, destRect, center,angle + 90, tint);
 }
 
+// moves the live bullets and returns the ones that run out of time to the pool
+void UpdateBullets(float dt)
+{
+    for (int i = 0; i < ActiveBullets.Count;)
+    {
+        int slot = ActiveBullets.Live[i];
+        Bullet* bullet = &Bullets[slot];
+
+        bullet->Lifetime -= dt;
+        if (bullet->Lifetime <= 0)
+        {
+            // the last live bullet was moved here, so look at this position again
+            DespawnBullet(&ActiveBullets, slot);
+            continue;
+        }
+
+        bullet->Position = Vector2Add(bullet->Position, Vector2Scale(bullet->Velocity, dt));
+        i++;
+    }
+}
+
+// all the bullets are drawn in one sprite batch, they spin together so they all share the same angle
+void DrawBullets()
+{
+    static Vector2 positions[MAX_BULLETS];
+    static float angles[MAX_BULLETS];
+
+    float angle = (float)GetTime() * 270 + 90;
+    for (int i = 0; i < ActiveBullets.Count; i++)
+    {
+        positions[i] = Bullets[ActiveBullets.Live[i]].Position;
+        angles[i] = angle;
+    }
+
+    // the same rectangles DrawEntity uses, centered on each bullet
+    Rectangle sourceRect = { 0,0,(float)BulletTexture.width, (float)BulletTexture.height };
+    Rectangle quad = { -sourceRect.width * 0.5f, -sourceRect.height * 0.5f, sourceRect.width, sourceRect.height };
+
+    DrawSpriteBatch(BulletTexture, sourceRect, quad, positions, angles, NULL, YELLOW, ActiveBullets.Count);
+}
+
 void UpdateGameState()
 {
     UpdatePlayer();
@@ -280,24 +1598,136 @@ void UpdateGameState()
             Enemies[i].ReloadTime -= GetFrameTime();
     }
 
-    for (int i = 0; i < MAX_BULLETS; i++)
+    UpdateBullets(GetFrameTime());
+    DrawBullets();
+}
+
+void DoFixedTimeStep(lua_State* luaState, float dt)
+{
+    RebuildSpatialGrid();
+
+    if (CurrentBehaviorMode == CoroutineBehaviors)
     {
-        Bullets[i].Lifetime -= GetFrameTime();
-        if (Bullets[i].Lifetime > 0)
-        {
-            Bullets[i].Position = Vector2Add(Bullets[i].Position, Vector2Scale(Bullets[i].Velocity, GetFrameTime()));
-            DrawEntity(Bullets[i].Position, (float)GetTime() * 270, BulletTexture, YELLOW);
-        }
+        DoCoroutineBehaviors(luaState, dt);
+        return;
+    }
+
+    int bucket = BehaviorTick % BEHAVIOR_BUCKETS;
+    BehaviorTick++;
+
+    if (UseScriptWorkers && ScriptWorkerCount > 0)
+        DoParallelEnemyBehaviors(bucket, dt * BEHAVIOR_BUCKETS);
+    else
+        DoEnemyBehaviors(luaState, bucket, dt * BEHAVIOR_BUCKETS);
+}
+
+// allocator benchmark
+// run with --alloc-benchmark to compare the pooled allocator against the C runtime on the enemy behaviors, without opening a window
+// first a batch of script states are created and thrown away, which is where most of the allocation happens (libraries, compiling, views)
+// then every behavior mode is run for the same number of ticks, and a set of full collections is timed to measure GC pauses
+#define BENCHMARK_STATES 200
+#define BENCHMARK_TICKS 50000
+#define BENCHMARK_COLLECTIONS 20
+
+void BenchmarkAllocator(bool usePools)
+{
+    UsePoolAllocator = usePools;
+
+    ScriptContext context;
+
+    unsigned long long startupAllocations = 0;
+    double startupStart = GetScriptTime();
+    for (int i = 0; i < BENCHMARK_STATES; i++)
+    {
+        lua_State* luaState = CreateScriptState(&context, 0, 1, NULL);
+        LoadCoroutineBehaviors(luaState);
+        startupAllocations += context.Allocator.Stats.Allocations;
+        DestroyScriptState(luaState);
+    }
+    double startupTime = GetScriptTime() - startupStart;
+
+    lua_State* luaState = CreateScriptState(&context, 0, 1, NULL);
+    LoadCoroutineBehaviors(luaState);
+
+    float dt = 1.0f / 60.0f;
+    double worstTick = 0;
+    double worstStep = 0;
+
+    double start = GetScriptTime();
+    for (int tick = 0; tick < BENCHMARK_TICKS; tick++)
+    {
+        double tickStart = GetScriptTime();
+
+        CurrentBehaviorMode = PerEnemyBehaviors;
+        DoEnemyBehaviors(luaState, tick % BEHAVIOR_BUCKETS, dt * BEHAVIOR_BUCKETS);
+        CurrentBehaviorMode = BatchBehaviors;
+        DoEnemyBehaviors(luaState, tick % BEHAVIOR_BUCKETS, dt * BEHAVIOR_BUCKETS);
+        DoCoroutineBehaviors(luaState, dt);
+
+        // let enemies reload and bullets expire so they keep firing
+        for (int i = 0; i < MAX_ENIMIES; i++)
+            Enemies[i].ReloadTime -= dt;
+        UpdateBullets(dt);
+
+        // the same per frame collection the game does
+        double stepStart = GetScriptTime();
+        StepScriptGC(luaState, GC_FRAME_BUDGET_US);
+        double stepTime = GetScriptTime() - stepStart;
+        if (stepTime > worstStep)
+            worstStep = stepTime;
+
+        double tickTime = GetScriptTime() - tickStart;
+        if (tickTime > worstTick)
+            worstTick = tickTime;
     }
+    double runTime = GetScriptTime() - start;
+    ScriptAllocStats runStats = context.Allocator.Stats;
+
+    double totalPause = 0;
+    double worstPause = 0;
+    for (int i = 0; i < BENCHMARK_COLLECTIONS; i++)
+    {
+        double pauseStart = GetScriptTime();
+        lua_gc(luaState, LUA_GCCOLLECT);
+        double pause = GetScriptTime() - pauseStart;
+
+        totalPause += pause;
+        if (pause > worstPause)
+            worstPause = pause;
+    }
+
+    printf("%s allocator\n", usePools ? "Pooled" : "C runtime");
+    printf("    %d states created in %.3f ms, %llu allocations, %.2f million allocations per second\n",
+        BENCHMARK_STATES, startupTime * 1000.0, startupAllocations, startupAllocations / startupTime / 1000000.0);
+    printf("    %d ticks in %.3f ms, worst tick %.1f us\n", BENCHMARK_TICKS, runTime * 1000.0, worstTick * 1000000.0);
+    printf("    %llu allocations, %llu frees, %llu large, %.2f million allocations per second\n",
+        runStats.Allocations, runStats.Frees, runStats.LargeAllocations, runStats.Allocations / runTime / 1000000.0);
+    printf("    %zu bytes in use, %zu peak, %zu in pages\n", runStats.BytesInUse, runStats.PeakBytesInUse, runStats.PageBytes);
+    printf("    worst GC frame step %.1f us\n", worstStep * 1000000.0);
+    printf("    full GC pause average %.1f us, worst %.1f us\n", totalPause / BENCHMARK_COLLECTIONS * 1000000.0, worstPause * 1000000.0);
+
+    DestroyScriptState(luaState);
 }
 
-void DoFixedTimeStep(float dt)
+void RunAllocatorBenchmark()
 {
+    InitBulletPool(&ActiveBullets, MAX_BULLETS);
+    SetupGame();
 
+    BenchmarkAllocator(false);
+    BenchmarkAllocator(true);
+
+    FreeBulletPool(&ActiveBullets);
 }
 
-int main()
+int main(int argc, char* argv[])
 {
+    if (argc > 1 && strcmp(argv[1], "--alloc-benchmark") == 0)
+    {
+        RunAllocatorBenchmark();
+        return 0;
+    }
+
     // set up the window
     SetConfigFlags(FLAG_VSYNC_HINT);
     InitWindow(1280, 800, "Hello Lua");
@@ -305,14 +1735,23 @@ int main()
 
     LoadResources();
 
+    InitBulletPool(&ActiveBullets, MAX_BULLETS);
     SetupGame();
 
-    // setup our lua state/context
-    lua_State* scriptState = luaL_newstate();
-    luaL_openlibs(scriptState);
+#if defined(SCRIPT_HOT_RELOAD)
+    // started first, so every script that gets loaded is watched
+    StartScriptWatcher(SCRIPT_FOLDER);
+#endif
 
-    // push our exposed API functions into lua
-    PushLuaAPI(scriptState);
+    // the main lua state runs behaviors itself when there are no workers, and is the only one that runs coroutine behaviors
+    ScriptContext mainContext;
+    lua_State* scriptState = CreateScriptState(&mainContext, 0, 1, NULL);
+    LoadCoroutineBehaviors(scriptState);
+
+    if (mainContext.BatchUpdateRef == LUA_NOREF)
+        CurrentBehaviorMode = PerEnemyBehaviors;
+
+    StartScriptWorkers();
 
     float accumulator = 0;
     float fixedTimeStep = 1.0f / 60.0f;
@@ -320,10 +1759,14 @@ int main()
     // game loop
     while (!WindowShouldClose())
     {
+#if defined(SCRIPT_HOT_RELOAD)
+        ApplyScriptReloads(scriptState);
+#endif
+
         accumulator += GetFrameTime();
         while (accumulator > fixedTimeStep)
         {
-            DoFixedTimeStep(fixedTimeStep);
+            DoFixedTimeStep(scriptState, fixedTimeStep);
             accumulator -= fixedTimeStep;
         }
 
@@ -331,13 +1774,36 @@ int main()
         BeginDrawing();
         ClearBackground(BLACK);
 
+        if (IsKeyPressed(KEY_B))
+            CurrentBehaviorMode = (CurrentBehaviorMode + 1) % 3;
+
+        if (IsKeyPressed(KEY_T))
+            UseScriptWorkers = !UseScriptWorkers;
+
+        if (IsKeyPressed(KEY_G))
+            SetAllScriptGCModes(scriptState, CurrentGCMode == IncrementalGC ? GenerationalGC : IncrementalGC);
+
         UpdateGameState();
 
-        DoEnemyBehaviors(scriptState);
+        DrawText(TextFormat("B = Behavior Mode (%s)", BehaviorModeNames[CurrentBehaviorMode]), 2, GetScreenHeight() - 20, 20, WHITE);
+        if (ScriptWorkerCount > 0)
+            DrawText(TextFormat("T = Script Workers (%s, %d threads)", UseScriptWorkers ? "On" : "Off", ScriptWorkerCount), 2, GetScreenHeight() - 40, 20, WHITE);
+
+        DrawText(TextFormat("G = GC Mode (%s) %d KB, %.3f ms last frame, %.3f ms worst, %d cycles", ScriptGCModeNames[CurrentGCMode],
+            GCStats.HeapKB, GCStats.FrameTime * 1000.0, GCStats.WorstFrameTime * 1000.0, GCStats.Cycles), 2, 2, 20, WHITE);
         EndDrawing();
+
+        // collect garbage in the time after the frame is presented
+        CollectScriptGarbage(scriptState);
     }
 
-    lua_close(scriptState);
+#if defined(SCRIPT_HOT_RELOAD)
+    StopScriptWatcher();
+#endif
+
+    StopScriptWorkers();
+    DestroyScriptState(scriptState);
+    FreeBulletPool(&ActiveBullets);
 
     // cleanup
     CloseWindow();
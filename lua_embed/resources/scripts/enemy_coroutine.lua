@@ -0,0 +1,19 @@
+-- coroutine lua script
+-- this file is run once to define behavior, each enemy then runs behavior in its own coroutine
+-- wait and wait_until pause the enemy, and the game carries on from there when it is time
+math.randomseed(os.time())
+
+function behavior(enemy)
+	while true do
+		-- do nothing until the player gets close
+		wait_until(function() return DistanceToPlayer(enemy.id) <= 400 end)
+
+		-- take aim, then fire
+		TurnTowardPlayer(enemy.id, 90)
+		wait(0.25)
+		EnemyFire(enemy.id, 300 + math.random(100,200))
+
+		-- rest before the next shot
+		wait(1 + math.random())
+	end
+end
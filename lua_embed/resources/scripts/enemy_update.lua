@@ -0,0 +1,26 @@
+-- batch lua script
+-- this file is run once to define update, the game then calls update once per frame with a list of every enemy
+math.randomseed(os.time())
+
+function update(enemies, dt)
+	for i = 0, #enemies - 1 do
+		local enemy = enemies[i]
+		local dx = Player.x - enemy.x
+		local dy = Player.y - enemy.y
+
+		if (math.sqrt(dx * dx + dy * dy) <= (300 + math.random(100,200))) then
+			enemy.angle = math.deg(math.atan(dy, dx))
+			if (enemy.reload <= 0) then
+				EnemyFire(enemy.id, 300 + math.random(100,200))
+			end
+		end
+
+		-- drift away from any other enemy that gets too close
+		for other, kind in QueryRadius(enemy.x, enemy.y, 50) do
+			if (kind == "enemy" and other.id ~= enemy.id) then
+				enemy.x = enemy.x + (enemy.x - other.x) * dt
+				enemy.y = enemy.y + (enemy.y - other.y) * dt
+			end
+		end
+	end
+end
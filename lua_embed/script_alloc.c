@@ -0,0 +1,141 @@
+#include "script_alloc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void InitScriptAllocator(ScriptAllocator* allocator, int usePools)
+{
+    memset(allocator, 0, sizeof(ScriptAllocator));
+    allocator->UsePools = usePools;
+}
+
+void FreeScriptAllocator(ScriptAllocator* allocator)
+{
+    ScriptAllocPage* page = allocator->Pages;
+    while (page)
+    {
+        ScriptAllocPage* next = page->Next;
+        free(page);
+        page = next;
+    }
+
+    InitScriptAllocator(allocator, allocator->UsePools);
+}
+
+// the class a block size falls in, or -1 for blocks that are too big to pool
+static int GetSizeClass(ScriptAllocator* allocator, size_t size)
+{
+    if (!allocator->UsePools || size > SCRIPT_ALLOC_GRANULARITY * SCRIPT_ALLOC_CLASSES)
+        return -1;
+
+    return (int)((size + SCRIPT_ALLOC_GRANULARITY - 1) / SCRIPT_ALLOC_GRANULARITY) - 1;
+}
+
+static void* AllocFromClass(ScriptAllocator* allocator, int sizeClass)
+{
+    void* block = allocator->FreeLists[sizeClass];
+    if (block)
+    {
+        // the next free block is stored in the first bytes of the free one
+        allocator->FreeLists[sizeClass] = *(void**)block;
+        return block;
+    }
+
+    size_t blockSize = (size_t)(sizeClass + 1) * SCRIPT_ALLOC_GRANULARITY;
+    if (allocator->PageCursor == NULL || allocator->PageCursor + blockSize > allocator->PageEnd)
+    {
+        // whatever is left at the end of the old page is small, and is just not used
+        ScriptAllocPage* page = (ScriptAllocPage*)malloc(SCRIPT_ALLOC_PAGE_SIZE);
+        if (page == NULL)
+            return NULL;
+
+        page->Next = allocator->Pages;
+        allocator->Pages = page;
+        allocator->PageCursor = (char*)page + SCRIPT_ALLOC_GRANULARITY; // keeps blocks aligned past the page header
+        allocator->PageEnd = (char*)page + SCRIPT_ALLOC_PAGE_SIZE;
+        allocator->Stats.PageBytes += SCRIPT_ALLOC_PAGE_SIZE;
+    }
+
+    block = allocator->PageCursor;
+    allocator->PageCursor += blockSize;
+    return block;
+}
+
+static void FreeToClass(ScriptAllocator* allocator, void* block, int sizeClass)
+{
+    *(void**)block = allocator->FreeLists[sizeClass];
+    allocator->FreeLists[sizeClass] = block;
+}
+
+void* ScriptAlloc(void* userData, void* block, size_t oldSize, size_t newSize)
+{
+    ScriptAllocator* allocator = (ScriptAllocator*)userData;
+
+    // when block is NULL oldSize is a hint about the object type, not a size
+    if (block == NULL)
+        oldSize = 0;
+
+    int oldClass = block ? GetSizeClass(allocator, oldSize) : -1;
+
+    if (newSize == 0)
+    {
+        if (block)
+        {
+            if (oldClass >= 0)
+                FreeToClass(allocator, block, oldClass);
+            else
+                free(block);
+
+            allocator->Stats.Frees++;
+            allocator->Stats.BytesInUse -= oldSize;
+        }
+        return NULL;
+    }
+
+    int newClass = GetSizeClass(allocator, newSize);
+    void* newBlock = NULL;
+
+    if (block && oldClass == newClass && newClass >= 0)
+    {
+        // same class, nothing to move
+        newBlock = block;
+    }
+    else if (newClass < 0 && (block == NULL || oldClass < 0))
+    {
+        // big to big, let the C runtime grow it in place if it can
+        newBlock = realloc(block, newSize);
+        if (newBlock == NULL)
+            return NULL;
+
+        allocator->Stats.LargeAllocations++;
+    }
+    else
+    {
+        newBlock = newClass >= 0 ? AllocFromClass(allocator, newClass) : malloc(newSize);
+        if (newBlock == NULL)
+            return NULL; // lua keeps the old block when an allocation fails
+
+        if (newClass < 0)
+            allocator->Stats.LargeAllocations++;
+
+        if (block)
+        {
+            memcpy(newBlock, block, oldSize < newSize ? oldSize : newSize);
+
+            if (oldClass >= 0)
+                FreeToClass(allocator, block, oldClass);
+            else
+                free(block);
+        }
+    }
+
+    if (block == NULL)
+        allocator->Stats.Allocations++;
+
+    allocator->Stats.BytesInUse += newSize;
+    allocator->Stats.BytesInUse -= oldSize;
+    if (allocator->Stats.BytesInUse > allocator->Stats.PeakBytesInUse)
+        allocator->Stats.PeakBytesInUse = allocator->Stats.BytesInUse;
+
+    return newBlock;
+}
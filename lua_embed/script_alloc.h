@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stddef.h>
+
+// a lua_Alloc that serves small blocks from size class free lists carved out of large pages
+// lua tells the allocator the old size of every block it frees or resizes, so blocks don't need a header to know their class
+// blocks bigger than the largest class go to the C runtime
+// an allocator belongs to one lua state, and is only touched by the thread running that state
+
+#define SCRIPT_ALLOC_GRANULARITY 16
+#define SCRIPT_ALLOC_CLASSES 16 // so the largest pooled block is 256 bytes
+#define SCRIPT_ALLOC_PAGE_SIZE (64 * 1024)
+
+typedef struct ScriptAllocPage
+{
+    struct ScriptAllocPage* Next;
+}ScriptAllocPage;
+
+typedef struct ScriptAllocStats
+{
+    size_t BytesInUse;
+    size_t PeakBytesInUse;
+    size_t PageBytes;
+
+    unsigned long long Allocations;
+    unsigned long long Frees;
+    unsigned long long LargeAllocations;
+}ScriptAllocStats;
+
+typedef struct ScriptAllocator
+{
+    void* FreeLists[SCRIPT_ALLOC_CLASSES];
+
+    ScriptAllocPage* Pages;
+    char* PageCursor;
+    char* PageEnd;
+
+    // when false every block goes to the C runtime, this is the same as luaL_newstate's allocator but with stats
+    int UsePools;
+
+    ScriptAllocStats Stats;
+}ScriptAllocator;
+
+void InitScriptAllocator(ScriptAllocator* allocator, int usePools);
+void FreeScriptAllocator(ScriptAllocator* allocator);
+
+// matches lua_Alloc, pass the ScriptAllocator as the user data to lua_newstate
+void* ScriptAlloc(void* userData, void* block, size_t oldSize, size_t newSize);
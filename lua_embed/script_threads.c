@@ -0,0 +1,309 @@
+#include "script_threads.h"
+
+// this file is kept apart from the raylib code since windows.h and raylib.h can not be included together
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+typedef HANDLE ThreadHandle;
+typedef SRWLOCK Mutex;
+typedef CONDITION_VARIABLE Condition;
+
+#define InitMutex(m) InitializeSRWLock(m)
+#define DestroyMutex(m)
+#define LockMutex(m) AcquireSRWLockExclusive(m)
+#define UnlockMutex(m) ReleaseSRWLockExclusive(m)
+#define InitCondition(c) InitializeConditionVariable(c)
+#define DestroyCondition(c)
+#define WaitCondition(c, m) SleepConditionVariableSRW(c, m, INFINITE, 0)
+#define BroadcastCondition(c) WakeAllConditionVariable(c)
+
+#else
+#include <pthread.h>
+#include <unistd.h>
+
+typedef pthread_t ThreadHandle;
+typedef pthread_mutex_t Mutex;
+typedef pthread_cond_t Condition;
+
+#define InitMutex(m) pthread_mutex_init(m, NULL)
+#define DestroyMutex(m) pthread_mutex_destroy(m)
+#define LockMutex(m) pthread_mutex_lock(m)
+#define UnlockMutex(m) pthread_mutex_unlock(m)
+#define InitCondition(c) pthread_cond_init(c, NULL)
+#define DestroyCondition(c) pthread_cond_destroy(c)
+#define WaitCondition(c, m) pthread_cond_wait(c, m)
+#define BroadcastCondition(c) pthread_cond_broadcast(c)
+#endif
+
+#include <stdlib.h>
+
+typedef struct
+{
+    ThreadHandle* Threads;
+    int* WorkerIndexes;
+    int WorkerCount;
+
+    WorkerJob Job;
+    void* UserData;
+
+    Mutex Lock;
+    Condition StartCondition;
+    Condition DoneCondition;
+
+    // bumped each time the pool is run, workers wait for it to change
+    unsigned int Generation;
+    int Pending;
+    bool Quit;
+}WorkerPool;
+
+static WorkerPool Pool = { 0 };
+
+int GetProcessorCount()
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+static void WorkerLoop(int workerIndex)
+{
+    unsigned int generation = 0;
+
+    LockMutex(&Pool.Lock);
+    while (true)
+    {
+        while (Pool.Generation == generation && !Pool.Quit)
+            WaitCondition(&Pool.StartCondition, &Pool.Lock);
+
+        if (Pool.Quit)
+            break;
+
+        generation = Pool.Generation;
+        UnlockMutex(&Pool.Lock);
+
+        Pool.Job(workerIndex, Pool.UserData);
+
+        LockMutex(&Pool.Lock);
+        Pool.Pending--;
+        if (Pool.Pending == 0)
+            BroadcastCondition(&Pool.DoneCondition);
+    }
+    UnlockMutex(&Pool.Lock);
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI WorkerThread(LPVOID arg)
+{
+    WorkerLoop(*(int*)arg);
+    return 0;
+}
+#else
+static void* WorkerThread(void* arg)
+{
+    WorkerLoop(*(int*)arg);
+    return NULL;
+}
+#endif
+
+int StartWorkerPool(int workerCount, WorkerJob job, void* userData)
+{
+    if (Pool.Threads != NULL || workerCount <= 0)
+        return 0;
+
+    Pool.Threads = (ThreadHandle*)calloc(workerCount, sizeof(ThreadHandle));
+    Pool.WorkerIndexes = (int*)calloc(workerCount, sizeof(int));
+    if (Pool.Threads == NULL || Pool.WorkerIndexes == NULL)
+    {
+        free(Pool.Threads);
+        free(Pool.WorkerIndexes);
+        Pool.Threads = NULL;
+        Pool.WorkerIndexes = NULL;
+        return 0;
+    }
+    Pool.Job = job;
+    Pool.UserData = userData;
+    Pool.Generation = 0;
+    Pool.Pending = 0;
+    Pool.Quit = false;
+
+    InitMutex(&Pool.Lock);
+    InitCondition(&Pool.StartCondition);
+    InitCondition(&Pool.DoneCondition);
+
+    for (int i = 0; i < workerCount; i++)
+    {
+        Pool.WorkerIndexes[i] = i;
+#if defined(_WIN32)
+        Pool.Threads[i] = CreateThread(NULL, 0, WorkerThread, &Pool.WorkerIndexes[i], 0, NULL);
+        bool started = Pool.Threads[i] != NULL;
+#else
+        bool started = pthread_create(&Pool.Threads[i], NULL, WorkerThread, &Pool.WorkerIndexes[i]) == 0;
+#endif
+        if (!started)
+        {
+            // keep the workers we did get, the caller decides if that is enough
+            workerCount = i;
+            break;
+        }
+    }
+
+    Pool.WorkerCount = workerCount;
+    if (workerCount == 0)
+    {
+        StopWorkerPool();
+        return 0;
+    }
+
+    return workerCount;
+}
+
+void RunWorkerPool()
+{
+    if (Pool.WorkerCount == 0)
+        return;
+
+    LockMutex(&Pool.Lock);
+    Pool.Pending = Pool.WorkerCount;
+    Pool.Generation++;
+    BroadcastCondition(&Pool.StartCondition);
+
+    while (Pool.Pending > 0)
+        WaitCondition(&Pool.DoneCondition, &Pool.Lock);
+    UnlockMutex(&Pool.Lock);
+}
+
+void StopWorkerPool()
+{
+    if (Pool.Threads == NULL)
+        return;
+
+    LockMutex(&Pool.Lock);
+    Pool.Quit = true;
+    BroadcastCondition(&Pool.StartCondition);
+    UnlockMutex(&Pool.Lock);
+
+    for (int i = 0; i < Pool.WorkerCount; i++)
+    {
+#if defined(_WIN32)
+        WaitForSingleObject(Pool.Threads[i], INFINITE);
+        CloseHandle(Pool.Threads[i]);
+#else
+        pthread_join(Pool.Threads[i], NULL);
+#endif
+    }
+
+    DestroyCondition(&Pool.DoneCondition);
+    DestroyCondition(&Pool.StartCondition);
+    DestroyMutex(&Pool.Lock);
+
+    free(Pool.Threads);
+    free(Pool.WorkerIndexes);
+    Pool.Threads = NULL;
+    Pool.WorkerIndexes = NULL;
+    Pool.WorkerCount = 0;
+}
+
+struct ScriptThread
+{
+    ThreadHandle Handle;
+    ThreadFunction Function;
+    void* UserData;
+};
+
+struct ScriptMutex
+{
+    Mutex Lock;
+};
+
+#if defined(_WIN32)
+static DWORD WINAPI ScriptThreadEntry(LPVOID arg)
+{
+    ScriptThread* thread = (ScriptThread*)arg;
+    thread->Function(thread->UserData);
+    return 0;
+}
+#else
+static void* ScriptThreadEntry(void* arg)
+{
+    ScriptThread* thread = (ScriptThread*)arg;
+    thread->Function(thread->UserData);
+    return NULL;
+}
+#endif
+
+ScriptThread* StartScriptThread(ThreadFunction function, void* userData)
+{
+    ScriptThread* thread = (ScriptThread*)calloc(1, sizeof(ScriptThread));
+    thread->Function = function;
+    thread->UserData = userData;
+
+#if defined(_WIN32)
+    thread->Handle = CreateThread(NULL, 0, ScriptThreadEntry, thread, 0, NULL);
+    bool started = thread->Handle != NULL;
+#else
+    bool started = pthread_create(&thread->Handle, NULL, ScriptThreadEntry, thread) == 0;
+#endif
+
+    if (!started)
+    {
+        free(thread);
+        return NULL;
+    }
+    return thread;
+}
+
+void JoinScriptThread(ScriptThread* thread)
+{
+    if (thread == NULL)
+        return;
+
+#if defined(_WIN32)
+    WaitForSingleObject(thread->Handle, INFINITE);
+    CloseHandle(thread->Handle);
+#else
+    pthread_join(thread->Handle, NULL);
+#endif
+    free(thread);
+}
+
+ScriptMutex* CreateScriptMutex()
+{
+    ScriptMutex* mutex = (ScriptMutex*)calloc(1, sizeof(ScriptMutex));
+    InitMutex(&mutex->Lock);
+    return mutex;
+}
+
+void DestroyScriptMutex(ScriptMutex* mutex)
+{
+    if (mutex == NULL)
+        return;
+
+    DestroyMutex(&mutex->Lock);
+    free(mutex);
+}
+
+void LockScriptMutex(ScriptMutex* mutex)
+{
+    LockMutex(&mutex->Lock);
+}
+
+void UnlockScriptMutex(ScriptMutex* mutex)
+{
+    UnlockMutex(&mutex->Lock);
+}
+
+void SleepMilliseconds(int milliseconds)
+{
+#if defined(_WIN32)
+    Sleep(milliseconds);
+#else
+    usleep((useconds_t)milliseconds * 1000);
+#endif
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdbool.h>
+
+// a small pool of worker threads that all run the same job at the same time
+// RunWorkerPool wakes every worker, and returns once they have all finished the job
+
+typedef void (*WorkerJob)(int workerIndex, void* userData);
+
+int GetProcessorCount();
+
+// returns how many workers really started, which can be fewer than asked for if the OS won't make more threads, or 0 on failure
+int StartWorkerPool(int workerCount, WorkerJob job, void* userData);
+void RunWorkerPool();
+void StopWorkerPool();
+
+// plain threads and locks, for background work that is not part of the pool
+
+typedef struct ScriptThread ScriptThread;
+typedef struct ScriptMutex ScriptMutex;
+
+typedef void (*ThreadFunction)(void* userData);
+
+ScriptThread* StartScriptThread(ThreadFunction function, void* userData);
+void JoinScriptThread(ScriptThread* thread);
+
+ScriptMutex* CreateScriptMutex();
+void DestroyScriptMutex(ScriptMutex* mutex);
+void LockScriptMutex(ScriptMutex* mutex);
+void UnlockScriptMutex(ScriptMutex* mutex);
+
+void SleepMilliseconds(int milliseconds);
@@ -0,0 +1,335 @@
+#include "script_watch.h"
+#include "script_threads.h"
+
+#include "lua.h"
+#include "lauxlib.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#define WATCH_POLL_MS 250
+
+typedef struct
+{
+    char File[MAX_WATCHED_PATH];
+    time_t ModTime;
+    long long FileSize; // modification times are only to the second, so a quick second save is caught by its size
+}WatchedFile;
+
+typedef struct
+{
+    char Folder[MAX_WATCHED_PATH];
+
+    ScriptThread* Thread;
+    ScriptMutex* Lock;
+
+    // guarded by Lock
+    bool Quit;
+    WatchedFile Files[MAX_WATCHED_SCRIPTS];
+    int FileCount;
+    CompiledScript Queue[MAX_WATCHED_SCRIPTS];
+    int QueueCount;
+
+#if defined(__linux__)
+    int Notify;
+#endif
+}ScriptWatcher;
+
+static ScriptWatcher Watcher = { 0 };
+
+static bool GetFileStamp(const char* file, time_t* modTime, long long* fileSize)
+{
+    struct stat info;
+    if (stat(file, &info) != 0)
+        return false;
+
+    *modTime = info.st_mtime;
+    *fileSize = (long long)info.st_size;
+    return true;
+}
+
+static bool ShouldQuit()
+{
+    LockScriptMutex(Watcher.Lock);
+    bool quit = Watcher.Quit;
+    UnlockScriptMutex(Watcher.Lock);
+    return quit;
+}
+
+typedef struct
+{
+    char* Data;
+    size_t Size;
+    size_t Capacity;
+}DumpBuffer;
+
+static int DumpWriter(lua_State* luaState, const void* data, size_t size, void* userData)
+{
+    DumpBuffer* buffer = (DumpBuffer*)userData;
+    if (buffer->Size + size > buffer->Capacity)
+    {
+        size_t capacity = buffer->Capacity > 0 ? buffer->Capacity * 2 : 4096;
+        while (capacity < buffer->Size + size)
+            capacity *= 2;
+
+        char* grown = (char*)realloc(buffer->Data, capacity);
+        if (grown == NULL)
+            return 1;
+
+        buffer->Data = grown;
+        buffer->Capacity = capacity;
+    }
+
+    memcpy(buffer->Data + buffer->Size, data, size);
+    buffer->Size += size;
+    return 0;
+}
+
+// compiles the file in a scratch state and queues up the bytecode, replacing any older version still in the queue
+static void CompileScript(const char* file)
+{
+    lua_State* luaState = luaL_newstate();
+
+    if (luaL_loadfile(luaState, file) != LUA_OK)
+    {
+        // leave the old version running, the game will pick up the next save
+        fprintf(stderr, "LUA: reload failed, %s\n", lua_tostring(luaState, -1));
+        lua_close(luaState);
+        return;
+    }
+
+    DumpBuffer buffer = { 0 };
+    bool dumped = lua_dump(luaState, DumpWriter, &buffer, 0) == 0;
+    lua_close(luaState);
+
+    if (!dumped)
+    {
+        free(buffer.Data);
+        return;
+    }
+
+    LockScriptMutex(Watcher.Lock);
+
+    CompiledScript* queued = NULL;
+    for (int i = 0; i < Watcher.QueueCount; i++)
+    {
+        if (strcmp(Watcher.Queue[i].File, file) == 0)
+        {
+            queued = &Watcher.Queue[i];
+            free(queued->Bytecode);
+            break;
+        }
+    }
+
+    if (queued == NULL && Watcher.QueueCount < MAX_WATCHED_SCRIPTS)
+        queued = &Watcher.Queue[Watcher.QueueCount++];
+
+    if (queued)
+    {
+        strcpy(queued->File, file);
+        queued->Bytecode = buffer.Data;
+        queued->Size = buffer.Size;
+    }
+    else
+    {
+        free(buffer.Data);
+    }
+
+    UnlockScriptMutex(Watcher.Lock);
+}
+
+// recompiles every watched file whose modification time or size has changed
+static void CheckWatchedFiles()
+{
+    char changed[MAX_WATCHED_SCRIPTS][MAX_WATCHED_PATH];
+    int changedCount = 0;
+
+    LockScriptMutex(Watcher.Lock);
+    for (int i = 0; i < Watcher.FileCount; i++)
+    {
+        WatchedFile* watched = &Watcher.Files[i];
+
+        time_t modTime = 0;
+        long long fileSize = 0;
+        if (!GetFileStamp(watched->File, &modTime, &fileSize))
+            continue;
+
+        if (modTime != watched->ModTime || fileSize != watched->FileSize)
+        {
+            watched->ModTime = modTime;
+            watched->FileSize = fileSize;
+            strcpy(changed[changedCount++], watched->File);
+        }
+    }
+    UnlockScriptMutex(Watcher.Lock);
+
+    // compile outside the lock so the game never waits on the compiler
+    for (int i = 0; i < changedCount; i++)
+        CompileScript(changed[i]);
+}
+
+#if defined(__linux__)
+// recompiles the watched files named in a block of inotify events
+static void HandleNotifyEvents(const char* events, ssize_t size)
+{
+    for (const char* event = events; event < events + size; )
+    {
+        const struct inotify_event* info = (const struct inotify_event*)event;
+        event += sizeof(struct inotify_event) + info->len;
+
+        if (info->len == 0)
+            continue;
+
+        char file[MAX_WATCHED_PATH];
+        if (snprintf(file, sizeof(file), "%s/%s", Watcher.Folder, info->name) >= (int)sizeof(file))
+            continue;
+
+        bool watched = false;
+        LockScriptMutex(Watcher.Lock);
+        for (int i = 0; i < Watcher.FileCount; i++)
+        {
+            if (strcmp(Watcher.Files[i].File, file) == 0)
+            {
+                watched = true;
+                GetFileStamp(file, &Watcher.Files[i].ModTime, &Watcher.Files[i].FileSize);
+            }
+        }
+        UnlockScriptMutex(Watcher.Lock);
+
+        if (watched)
+            CompileScript(file);
+    }
+}
+#endif
+
+static void WatcherThread(void* userData)
+{
+    while (!ShouldQuit())
+    {
+#if defined(__linux__)
+        if (Watcher.Notify >= 0)
+        {
+            // wake up every so often to check if we should quit
+            struct pollfd pollInfo = { Watcher.Notify, POLLIN, 0 };
+            if (poll(&pollInfo, 1, WATCH_POLL_MS) <= 0)
+                continue;
+
+            char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+            ssize_t size = read(Watcher.Notify, events, sizeof(events));
+            if (size > 0)
+                HandleNotifyEvents(events, size);
+            continue;
+        }
+#endif
+        SleepMilliseconds(WATCH_POLL_MS);
+        CheckWatchedFiles();
+    }
+}
+
+bool StartScriptWatcher(const char* folder)
+{
+    if (Watcher.Thread != NULL || strlen(folder) >= MAX_WATCHED_PATH)
+        return false;
+
+    strcpy(Watcher.Folder, folder);
+    Watcher.Lock = CreateScriptMutex();
+    Watcher.Quit = false;
+    Watcher.FileCount = 0;
+    Watcher.QueueCount = 0;
+
+#if defined(__linux__)
+    // editors often save by writing a new file and renaming it over the old one, so watch for moves as well as writes
+    Watcher.Notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (Watcher.Notify >= 0 && inotify_add_watch(Watcher.Notify, folder, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0)
+    {
+        close(Watcher.Notify);
+        Watcher.Notify = -1;
+    }
+#endif
+
+    Watcher.Thread = StartScriptThread(WatcherThread, NULL);
+    if (Watcher.Thread == NULL)
+    {
+        StopScriptWatcher();
+        return false;
+    }
+
+    return true;
+}
+
+void StopScriptWatcher()
+{
+    if (Watcher.Lock == NULL)
+        return;
+
+    LockScriptMutex(Watcher.Lock);
+    Watcher.Quit = true;
+    UnlockScriptMutex(Watcher.Lock);
+
+    JoinScriptThread(Watcher.Thread);
+    Watcher.Thread = NULL;
+
+#if defined(__linux__)
+    if (Watcher.Notify >= 0)
+        close(Watcher.Notify);
+    Watcher.Notify = -1;
+#endif
+
+    for (int i = 0; i < Watcher.QueueCount; i++)
+        free(Watcher.Queue[i].Bytecode);
+    Watcher.QueueCount = 0;
+
+    DestroyScriptMutex(Watcher.Lock);
+    Watcher.Lock = NULL;
+}
+
+void WatchScriptFile(const char* file)
+{
+    if (Watcher.Lock == NULL || strlen(file) >= MAX_WATCHED_PATH)
+        return;
+
+    LockScriptMutex(Watcher.Lock);
+
+    bool found = false;
+    for (int i = 0; i < Watcher.FileCount; i++)
+    {
+        if (strcmp(Watcher.Files[i].File, file) == 0)
+            found = true;
+    }
+
+    if (!found && Watcher.FileCount < MAX_WATCHED_SCRIPTS)
+    {
+        WatchedFile* watched = &Watcher.Files[Watcher.FileCount++];
+        strcpy(watched->File, file);
+        GetFileStamp(file, &watched->ModTime, &watched->FileSize);
+    }
+
+    UnlockScriptMutex(Watcher.Lock);
+}
+
+bool PollCompiledScript(CompiledScript* script)
+{
+    if (Watcher.Lock == NULL)
+        return false;
+
+    LockScriptMutex(Watcher.Lock);
+
+    bool found = Watcher.QueueCount > 0;
+    if (found)
+    {
+        *script = Watcher.Queue[0];
+        Watcher.QueueCount--;
+        memmove(Watcher.Queue, Watcher.Queue + 1, sizeof(CompiledScript) * Watcher.QueueCount);
+    }
+
+    UnlockScriptMutex(Watcher.Lock);
+    return found;
+}
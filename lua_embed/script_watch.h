@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// watches script files for changes and recompiles them on a background thread
+// on linux the folder is watched with inotify, everywhere else the files' modification times are polled
+// the compiled bytecode is queued up for the game to swap in when it is ready, so the game never reads or parses a script itself
+
+#define MAX_WATCHED_SCRIPTS 16
+#define MAX_WATCHED_PATH 256
+
+typedef struct CompiledScript
+{
+    char File[MAX_WATCHED_PATH];
+    char* Bytecode; // owned by whoever takes it from the queue, release with free()
+    size_t Size;
+}CompiledScript;
+
+bool StartScriptWatcher(const char* folder);
+void StopScriptWatcher();
+
+// adds a file to the set that gets recompiled when it changes, the file must be in the watched folder
+void WatchScriptFile(const char* file);
+
+// takes the next recompiled script off the queue, returns false if there are none
+bool PollCompiledScript(CompiledScript* script);
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "raylib.h"
+
+// draws many copies of a sprite with one stream of quads, instead of a DrawTexturePro call for each one
+// the corners of every sprite are rotated on the CPU a chunk at a time, then sent to rlgl together
+// rlgl merges quads that use the same texture into a single draw call, so the number of draw calls doesn't grow with the number of sprites
+
+// texture and source are the same as DrawTexturePro, a texture with an id of 0 uses the default white texture, for solid colored shapes
+// quad is the rectangle to draw in the sprite's own space, so { -w/2, -h/2, w, h } is centered on each position
+// angles are in degrees and can be NULL for sprites that don't rotate, colors can be NULL to draw every sprite with tint
+void DrawSpriteBatch(Texture2D texture, Rectangle source, Rectangle quad, const Vector2* positions, const float* angles, const Color* colors, Color tint, int count);
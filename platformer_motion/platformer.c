@@ -31,134 +31,93 @@
 
 #include "raylib.h"
 
-// checks a moving rectangle against some static object, stopping them motion based on what side of the static object is hit.
-// hit booleans return back what part of the object was hit to help with state collisons
-void CollideRectWithObject(const Rectangle mover, const Rectangle object, Vector2* motion, bool* hitSide, bool* hitTop, bool* hitBottom)
+#include "rect_grid.h"
+#include "swept_aabb.h"
+#include "tilemap.h"
+
+// function to return a fixed timestep when debugging
+float GetDeltaTime()
 {
-	if (!motion)
-		return;
+#ifdef _DEBUG
+	return 1 / 60.0f;
+#else
+	return GetFrameTime();
+#endif
+}
 
-	// check the X axis
-	float oldRight = mover.x + mover.width;
-	float oldBottom = mover.y + mover.height;
 
-	Rectangle newrect = mover;
-	newrect.x += motion->x;
-	newrect.y += motion->y;
+#define MAX_WALLS 7
 
-	if (!CheckCollisionRecs(newrect, object))
-		return;
+// the walls are put in a grid, so the player is only swept against the walls near where it is moving
+#define WALL_GRID_CELL_SIZE 100.0f
+#define MAX_WALL_CANDIDATES 64
+
+// press M to switch to a tile map level, a long run of procedural platforms stored as one bit per tile
+// only the tiles under the player's move are checked, so the size of the level doesn't matter
+#define TILE_SIZE 25
+#define LEVEL_WIDTH 65536
+#define LEVEL_HEIGHT 64
+#define LEVEL_FILE "resources/level.tmap"
+#define MAX_TILE_CANDIDATES 1024
+
+// a small random number generator, so the generated level is the same everywhere
+unsigned int LevelSeed = 12345;
+int LevelRandom(int min, int max)
+{
+	LevelSeed = LevelSeed * 1103515245 + 12345;
+	return min + (int)((LevelSeed >> 16) % (unsigned int)(max - min + 1));
+}
 
-	bool canHitX = true;
-	if (newrect.y > object.y + object.height)	// our top is below wall bottom
-		canHitX = false;
-	else if (newrect.y + newrect.height < object.y) // our bottom is over the wall top
-		canHitX = false;
+// builds the tile level, starting with the same walls as the rectangle level and then a long run of platforms and pits
+void GenerateTileLevel(TileMap* map, const Rectangle* walls, int wallCount)
+{
+	InitTileMap(map, LEVEL_WIDTH, LEVEL_HEIGHT, TILE_SIZE);
 
-	if (canHitX)
+	// everything but the right wall, so the level carries on past it
+	for (int i = 0; i < wallCount; i++)
 	{
-		float newRight = newrect.x + newrect.width;
-		float objectRight = object.x + object.width;
-
-		// check the box moving to the right
-		// if we were outside the left wall before, and are not now, we hit something
-		if (motion->x > 0)
-		{
-			if (oldRight <= object.x)
-			{
-				if (newRight > object.x)
-				{
-					// we hit moving right, so set us back to where we hit the wall
-					newrect.x = object.x - mover.width;
-					if (hitSide)
-						*hitSide = true;
-				}
-			}		
-		}
-		
-		if (motion->x < 0)
-		{
-			// check the box moving to the left
-			// if we were outside the right wall before, and are not now, we hit something
-			if (mover.x >= objectRight)
-			{
-				if (newrect.x < objectRight)
-				{
-					// we hit moving left, so set us back to where we hit the wall
-					newrect.x = objectRight;
-					if (hitSide)
-						*hitSide = true;
-				}
-			}
-		}
+		if (walls[i].x < 1200)
+			FillTileRect(map, walls[i]);
 	}
 
-	// do the same for Y
-	bool canHitY = true;
-	if (newrect.x > object.x + object.width)		// our left is past wall right
-		canHitY = false;
-	else if (newrect.x + newrect.width < object.x)	// our right is past wall left
-		canHitY = false;
+	// a solid bottom for anything that falls into a pit
+	FillTileRect(map, (Rectangle){ 0, (LEVEL_HEIGHT - 1) * TILE_SIZE, LEVEL_WIDTH * TILE_SIZE, TILE_SIZE });
 
-	if (canHitY)
+	int floorRow = 23;
+	int x = 1300 / TILE_SIZE;
+	while (x < LEVEL_WIDTH)
 	{
-		float newBottom = newrect.y + newrect.height;
-		float objectBottom = object.y + object.height;
-
-		// check the box moving to the down
-		// if we were outside the top wall before, and are not now, we hit something
-		if (motion->y >= 0)
+		// a stretch of floor, then a pit
+		int floorLength = LevelRandom(8, 40);
+		for (int i = x; i < x + floorLength && i < LEVEL_WIDTH; i++)
 		{
-			if (oldBottom <= object.y)
-			{
-				if (newBottom > object.y)
-				{
-					// we hit moving down, so set us back to where we hit the wall
-					newrect.y = object.y - mover.height;
-					if (hitBottom)
-						*hitBottom = true;
-				}
-				else if (newBottom == object.y)
-				{
-					if (hitBottom)
-						*hitBottom = true;
-				}
-			}
+			SetTileSolid(map, i, floorRow, true);
+			SetTileSolid(map, i, floorRow + 1, true);
 		}
-		else if (motion->y < 0)
+
+		// some platforms over the floor
+		int platforms = LevelRandom(0, 3);
+		for (int p = 0; p < platforms; p++)
 		{
-			// check the box moving up
-			// if we were outside the bottom wall before, and are not now, we hit something
-			if (mover.y >= objectBottom)
-			{
-				if (newrect.y < objectBottom)
-				{
-					// we hit moving up, so set us back to where we hit the wall
-					newrect.y = objectBottom;
-					if (hitTop)
-						*hitTop = true;
-				}
-			}
- 		}
-	}
+			int platformX = x + LevelRandom(0, floorLength);
+			int platformY = LevelRandom(10, floorRow - 4);
+			int platformLength = LevelRandom(3, 12);
+			for (int i = platformX; i < platformX + platformLength; i++)
+				SetTileSolid(map, i, platformY, true);
+		}
 
-	motion->x = newrect.x - mover.x;
-	motion->y = newrect.y - mover.y;
-}
+		// sometimes a pillar to jump over
+		if (LevelRandom(0, 3) == 0)
+		{
+			int pillarX = x + LevelRandom(2, floorLength);
+			for (int y = floorRow - LevelRandom(1, 2); y < floorRow; y++)
+				SetTileSolid(map, pillarX, y, true);
+		}
 
-// function to return a fixed timestep when debugging
-float GetDeltaTime()
-{
-#ifdef _DEBUG
-	return 1 / 60.0f;
-#else
-	return GetFrameTime();
-#endif
+		x += floorLength + LevelRandom(2, 5);
+	}
 }
 
-
-#define MAX_WALLS 7
-
 // main entry point
 int main(void)
 {
@@ -176,9 +135,31 @@ int main(void)
 	walls[4] = (Rectangle){ 1255,0,25,600 };
 	walls[5] = (Rectangle){ 0,200,400,25 };
 	walls[6] = (Rectangle){ 880,200,400,25 };
+
+	RectGrid wallGrid;
+	BuildRectGrid(&wallGrid, walls, MAX_WALLS, WALL_GRID_CELL_SIZE);
+
+	// load the tile level, or make it if it isn't there
+	TileMap level = { 0 };
+	if (!LoadTileMap(&level, LEVEL_FILE))
+	{
+		GenerateTileLevel(&level, walls, MAX_WALLS);
+		SaveTileMap(&level, LEVEL_FILE);
+	}
+
+	bool useTileMap = false;
+	Rectangle tiles[MAX_TILE_CANDIDATES];
+	int tileIndexes[MAX_TILE_CANDIDATES];
+	for (int i = 0; i < MAX_TILE_CANDIDATES; i++)
+		tileIndexes[i] = i;
+
+	// the camera follows the player on the tile level
+	Camera2D camera = { 0 };
+	camera.zoom = 1;
 	
 	// set up a player
-	Rectangle player = { 300,300, 20,50 };
+	const Rectangle playerStart = { 300,300, 20,50 };
+	Rectangle player = playerStart;
 
 	// state data for our player
 	bool hitSide = false;
@@ -192,11 +173,22 @@ int main(void)
 	// game loop
 	while (!WindowShouldClose())
 	{
+		if (IsKeyPressed(KEY_M))
+		{
+			useTileMap = !useTileMap;
+			player = playerStart;
+			movement = (Vector2){ 0,0 };
+		}
+
 		// movement
 		float speed = GetDeltaTime() * 300;
 		float gravity = GetDeltaTime() * 16;
 		float jump = GetDeltaTime() * -600;
 
+		// hold shift to run very fast, the collisions are swept so the player still can't pass through walls
+		if (IsKeyDown(KEY_LEFT_SHIFT))
+			speed *= 20;
+
 		// if we are not falling we can move and jump
 		if (!falling)
 		{
@@ -228,9 +220,22 @@ int main(void)
 		hitBottom = false;
 		hitTop = false;
 	
-		// check all the walls, letting each one have a chance to modify the possible motion
-		for (int i = 0; i < MAX_WALLS; i++)
-			CollideRectWithObject(player, walls[i], &movement, &hitSide, &hitTop, &hitBottom);
+		// find the walls that could be hit by this move, then sweep the player through them, sliding along anything it hits
+		Rectangle sweptBounds = GetSweptRectBounds(player, movement);
+
+		// reach a little below the player, so the floor it is standing on is always a candidate
+		sweptBounds.height += 1;
+		if (useTileMap)
+		{
+			int tileCount = GatherSolidTiles(&level, sweptBounds, tiles, MAX_TILE_CANDIDATES);
+			MoveRectAndSlide(player, tiles, tileIndexes, tileCount, &movement, &hitSide, &hitTop, &hitBottom);
+		}
+		else
+		{
+			int candidates[MAX_WALL_CANDIDATES];
+			int candidateCount = QueryRectGrid(&wallGrid, sweptBounds, candidates, MAX_WALL_CANDIDATES);
+			MoveRectAndSlide(player, walls, candidates, candidateCount, &movement, &hitSide, &hitTop, &hitBottom);
+		}
 
 		player.x += movement.x;
 		player.y += movement.y;
@@ -238,20 +243,42 @@ int main(void)
 		// if we are not on a thing and moving down, we are falling
 		falling = !hitBottom && movement.y != 0;
 
+		// keep the player in the middle of the screen on the tile level
+		if (useTileMap)
+		{
+			camera.offset = (Vector2){ GetScreenWidth() * 0.5f, GetScreenHeight() * 0.5f };
+			camera.target = (Vector2){ player.x + player.width * 0.5f, player.y + player.height * 0.5f };
+		}
+		else
+		{
+			camera.offset = (Vector2){ 0,0 };
+			camera.target = (Vector2){ 0,0 };
+		}
+
 		// draw the scene
 		BeginDrawing();
 		ClearBackground(LIGHTGRAY);
-		
-		// draw a simple grid
-		for (int x = 0; x < 1300; x += 25)
+		BeginMode2D(camera);
+
+		if (useTileMap)
 		{
-			DrawLine(x, 0, x, 1300, GRAY);
-			DrawLine(0, x, 1300, x, GRAY);
+			// only the tiles on screen are drawn
+			Vector2 viewStart = GetScreenToWorld2D((Vector2){ 0,0 }, camera);
+			DrawTileMap(&level, (Rectangle){ viewStart.x, viewStart.y, (float)GetScreenWidth(), (float)GetScreenHeight() }, RED);
 		}
+		else
+		{
+			// draw a simple grid
+			for (int x = 0; x < 1300; x += 25)
+			{
+				DrawLine(x, 0, x, 1300, GRAY);
+				DrawLine(0, x, 1300, x, GRAY);
+			}
 
-		// draw all the walls and floors
-		for (int i = 0; i < MAX_WALLS; i++)
-			DrawRectangleRec(walls[i], RED);
+			// draw all the walls and floors
+			for (int i = 0; i < MAX_WALLS; i++)
+				DrawRectangleRec(walls[i], RED);
+		}
 
 		// draw the player in a different color depending on what state they are in
 		Color playerColor = BLUE;
@@ -267,9 +294,16 @@ int main(void)
 
 		DrawRectangleRec(player, playerColor);
 
+		EndMode2D();
+
+		DrawText(useTileMap ? TextFormat("Tile level, %d x %d tiles, M = rectangle level", level.Width, level.Height) : "Rectangle level, M = tile level", 30, 10, 20, BLACK);
+
 		EndDrawing();
 	}
 
+	FreeRectGrid(&wallGrid);
+	FreeTileMap(&level);
+
 	CloseWindow();
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "rect_grid.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// keeps a grid over a huge or sparse map from using too much memory
+#define MAX_GRID_CELLS (1024 * 1024)
+
+static int ClampCell(int value, int max)
+{
+    if (value < 0)
+        return 0;
+    if (value >= max)
+        return max - 1;
+    return value;
+}
+
+// the cells a rectangle covers, clamped to the grid
+static void GetCellRange(const RectGrid* grid, Rectangle rect, int* minX, int* minY, int* maxX, int* maxY)
+{
+    *minX = ClampCell((int)floorf((rect.x - grid->Origin.x) / grid->CellSize), grid->Columns);
+    *minY = ClampCell((int)floorf((rect.y - grid->Origin.y) / grid->CellSize), grid->Rows);
+    *maxX = ClampCell((int)floorf((rect.x + rect.width - grid->Origin.x) / grid->CellSize), grid->Columns);
+    *maxY = ClampCell((int)floorf((rect.y + rect.height - grid->Origin.y) / grid->CellSize), grid->Rows);
+}
+
+bool BuildRectGrid(RectGrid* grid, const Rectangle* rects, int count, float cellSize)
+{
+    memset(grid, 0, sizeof(RectGrid));
+    grid->Rects = rects;
+    grid->RectCount = count;
+
+    // size the grid to fit every rectangle
+    Vector2 min = { 0, 0 };
+    Vector2 max = { 0, 0 };
+    for (int i = 0; i < count; i++)
+    {
+        if (i == 0 || rects[i].x < min.x)
+            min.x = rects[i].x;
+        if (i == 0 || rects[i].y < min.y)
+            min.y = rects[i].y;
+        if (i == 0 || rects[i].x + rects[i].width > max.x)
+            max.x = rects[i].x + rects[i].width;
+        if (i == 0 || rects[i].y + rects[i].height > max.y)
+            max.y = rects[i].y + rects[i].height;
+    }
+
+    grid->Origin = min;
+    grid->CellSize = cellSize;
+    grid->Columns = (int)((max.x - min.x) / cellSize) + 1;
+    grid->Rows = (int)((max.y - min.y) / cellSize) + 1;
+
+    while ((long long)grid->Columns * grid->Rows > MAX_GRID_CELLS)
+    {
+        grid->CellSize *= 2;
+        grid->Columns = (int)((max.x - min.x) / grid->CellSize) + 1;
+        grid->Rows = (int)((max.y - min.y) / grid->CellSize) + 1;
+    }
+
+    int cellCount = grid->Columns * grid->Rows;
+    grid->CellStarts = (int*)calloc(cellCount + 1, sizeof(int));
+    grid->QueryStamps = (unsigned int*)calloc(count > 0 ? count : 1, sizeof(unsigned int));
+    if (!grid->CellStarts || !grid->QueryStamps)
+    {
+        FreeRectGrid(grid);
+        return false;
+    }
+
+    // count how many rectangles touch each cell
+    int itemCount = 0;
+    for (int i = 0; i < count; i++)
+    {
+        int minX, minY, maxX, maxY;
+        GetCellRange(grid, rects[i], &minX, &minY, &maxX, &maxY);
+
+        for (int y = minY; y <= maxY; y++)
+        {
+            for (int x = minX; x <= maxX; x++)
+                grid->CellStarts[y * grid->Columns + x + 1]++;
+        }
+
+        itemCount += (maxX - minX + 1) * (maxY - minY + 1);
+    }
+
+    // turn the counts into where each cell starts
+    for (int cell = 0; cell < cellCount; cell++)
+        grid->CellStarts[cell + 1] += grid->CellStarts[cell];
+
+    grid->CellItems = (int*)malloc(sizeof(int) * (itemCount > 0 ? itemCount : 1));
+    int* cursors = (int*)malloc(sizeof(int) * cellCount);
+    if (!grid->CellItems || !cursors)
+    {
+        free(cursors);
+        FreeRectGrid(grid);
+        return false;
+    }
+
+    memcpy(cursors, grid->CellStarts, sizeof(int) * cellCount);
+
+    for (int i = 0; i < count; i++)
+    {
+        int minX, minY, maxX, maxY;
+        GetCellRange(grid, rects[i], &minX, &minY, &maxX, &maxY);
+
+        for (int y = minY; y <= maxY; y++)
+        {
+            for (int x = minX; x <= maxX; x++)
+                grid->CellItems[cursors[y * grid->Columns + x]++] = i;
+        }
+    }
+
+    free(cursors);
+    return true;
+}
+
+void FreeRectGrid(RectGrid* grid)
+{
+    free(grid->CellStarts);
+    free(grid->CellItems);
+    free(grid->QueryStamps);
+
+    memset(grid, 0, sizeof(RectGrid));
+}
+
+int QueryRectGrid(RectGrid* grid, Rectangle area, int* candidates, int maxCandidates)
+{
+    if (grid->RectCount == 0)
+        return 0;
+
+    // a new stamp for each query means the stamps never have to be cleared, except when the counter wraps
+    grid->QueryStamp++;
+    if (grid->QueryStamp == 0)
+    {
+        memset(grid->QueryStamps, 0, sizeof(unsigned int) * grid->RectCount);
+        grid->QueryStamp = 1;
+    }
+
+    int minX, minY, maxX, maxY;
+    GetCellRange(grid, area, &minX, &minY, &maxX, &maxY);
+
+    int found = 0;
+    for (int y = minY; y <= maxY; y++)
+    {
+        for (int x = minX; x <= maxX; x++)
+        {
+            int cell = y * grid->Columns + x;
+            for (int item = grid->CellStarts[cell]; item < grid->CellStarts[cell + 1]; item++)
+            {
+                int rect = grid->CellItems[item];
+                if (grid->QueryStamps[rect] == grid->QueryStamp)
+                    continue;
+
+                grid->QueryStamps[rect] = grid->QueryStamp;
+
+                if (!CheckCollisionRecs(grid->Rects[rect], area))
+                    continue;
+
+                candidates[found++] = rect;
+                if (found == maxCandidates)
+                    return found;
+            }
+        }
+    }
+
+    return found;
+}
+
+Rectangle GetSweptRectBounds(Rectangle rect, Vector2 motion)
+{
+    float minX = fminf(rect.x, rect.x + motion.x);
+    float minY = fminf(rect.y, rect.y + motion.y);
+    float maxX = fmaxf(rect.x, rect.x + motion.x) + rect.width;
+    float maxY = fmaxf(rect.y, rect.y + motion.y) + rect.height;
+
+    return (Rectangle){ minX, minY, maxX - minX, maxY - minY };
+}
@@ -0,0 +1,169 @@
+#include "swept_aabb.h"
+
+#include <math.h>
+
+#define MAX_SLIDE_ITERATIONS 3
+
+// how close the bottom of a mover has to be to the top of an object to be standing on it
+#define GROUND_PROBE_DISTANCE 0.01f
+
+// the times the mover enters and leaves an object along one axis
+// when there is no motion on the axis, the mover is either always overlapping on it, or never
+static bool GetAxisTimes(float moverMin, float moverSize, float motion, float objectMin, float objectSize, float* entry, float* exit)
+{
+    float moverMax = moverMin + moverSize;
+    float objectMax = objectMin + objectSize;
+
+    if (motion > 0)
+    {
+        *entry = (objectMin - moverMax) / motion;
+        *exit = (objectMax - moverMin) / motion;
+    }
+    else if (motion < 0)
+    {
+        *entry = (objectMax - moverMin) / motion;
+        *exit = (objectMin - moverMax) / motion;
+    }
+    else
+    {
+        // just touching isn't overlapping, so a mover can slide flush along a wall
+        if (moverMax <= objectMin || moverMin >= objectMax)
+            return false;
+
+        *entry = -INFINITY;
+        *exit = INFINITY;
+    }
+
+    return true;
+}
+
+bool SweepRect(Rectangle mover, Vector2 motion, Rectangle object, float* time, Vector2* normal)
+{
+    float entryX, exitX, entryY, exitY;
+    if (!GetAxisTimes(mover.x, mover.width, motion.x, object.x, object.width, &entryX, &exitX))
+        return false;
+    if (!GetAxisTimes(mover.y, mover.height, motion.y, object.y, object.height, &entryY, &exitY))
+        return false;
+
+    float entry = fmaxf(entryX, entryY);
+    float exit = fminf(exitX, exitY);
+
+    // it has to start touching before it stops, and within this motion
+    if (entry >= exit || entry > 1 || exit <= 0)
+        return false;
+
+    // already overlapping on both axes, let it move out
+    if (entry < 0)
+        return false;
+
+    *time = entry;
+    if (entryX > entryY)
+        *normal = (Vector2){ motion.x > 0 ? -1.0f : 1.0f, 0 };
+    else
+        *normal = (Vector2){ 0, motion.y > 0 ? -1.0f : 1.0f };
+
+    return true;
+}
+
+bool SweepRectAgainstObjects(Rectangle mover, Vector2 motion, const Rectangle* objects, const int* candidates, int candidateCount, SweepHit* hit)
+{
+    bool found = false;
+
+    for (int i = 0; i < candidateCount; i++)
+    {
+        float time;
+        Vector2 normal;
+        if (!SweepRect(mover, motion, objects[candidates[i]], &time, &normal))
+            continue;
+
+        if (!found || time < hit->Time)
+        {
+            hit->Time = time;
+            hit->Normal = normal;
+            hit->Object = candidates[i];
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+bool IsRectOnGround(Rectangle mover, const Rectangle* objects, const int* candidates, int candidateCount)
+{
+    float bottom = mover.y + mover.height;
+    for (int i = 0; i < candidateCount; i++)
+    {
+        Rectangle object = objects[candidates[i]];
+
+        // only standing on it if it is under the mover, not just touching a corner
+        if (mover.x + mover.width <= object.x || mover.x >= object.x + object.width)
+            continue;
+
+        if (fabsf(object.y - bottom) <= GROUND_PROBE_DISTANCE)
+            return true;
+    }
+
+    return false;
+}
+
+void MoveRectAndSlide(Rectangle mover, const Rectangle* objects, const int* candidates, int candidateCount, Vector2* motion, bool* hitSide, bool* hitTop, bool* hitBottom)
+{
+    if (!motion)
+        return;
+
+    Rectangle start = mover;
+    Vector2 remaining = *motion;
+
+    for (int iteration = 0; iteration < MAX_SLIDE_ITERATIONS; iteration++)
+    {
+        if (remaining.x == 0 && remaining.y == 0)
+            break;
+
+        SweepHit hit;
+        if (!SweepRectAgainstObjects(mover, remaining, objects, candidates, candidateCount, &hit))
+        {
+            mover.x += remaining.x;
+            mover.y += remaining.y;
+            remaining = (Vector2){ 0, 0 };
+            break;
+        }
+
+        Rectangle object = objects[hit.Object];
+
+        // move up to the hit, putting the side that hit exactly against the object so there is no gap or overlap from rounding
+        if (hit.Normal.x != 0)
+        {
+            mover.x = hit.Normal.x < 0 ? object.x - mover.width : object.x + object.width;
+            mover.y += remaining.y * hit.Time;
+
+            // slide along the side, with the rest of the vertical motion
+            remaining.x = 0;
+            remaining.y *= 1 - hit.Time;
+
+            if (hitSide)
+                *hitSide = true;
+        }
+        else
+        {
+            mover.y = hit.Normal.y < 0 ? object.y - mover.height : object.y + object.height;
+            mover.x += remaining.x * hit.Time;
+
+            // slide along the top or bottom, with the rest of the horizontal motion
+            remaining.y = 0;
+            remaining.x *= 1 - hit.Time;
+
+            if (hit.Normal.y < 0 && hitBottom)
+                *hitBottom = true;
+            if (hit.Normal.y > 0 && hitTop)
+                *hitTop = true;
+        }
+    }
+
+    motion->x = mover.x - start.x;
+    motion->y = mover.y - start.y;
+
+    // with no downward motion the sweep never touches the floor, so check if the mover is still standing on it
+    // without this a mover resting on the floor would only hit it every other step, when gravity pulled it down
+    if (hitBottom && !*hitBottom && motion->y >= 0)
+        *hitBottom = IsRectOnGround(mover, objects, candidates, candidateCount);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "raylib.h"
+
+#include <stdbool.h>
+
+// continuous collision for a moving rectangle against static rectangles
+// instead of moving and then checking for overlap, the motion is swept to find the time it first touches something
+// so a mover can't skip through a wall in one frame however fast it goes
+
+typedef struct SweepHit
+{
+    float Time;     // how far along the motion the hit is, from 0 to 1
+    Vector2 Normal; // the side of the object that was hit, pointing out of it
+    int Object;     // the index of the object that was hit
+}SweepHit;
+
+// finds when mover, moving by motion, first touches object
+// touching counts as a hit when moving into the object, so a mover resting on a floor hits it at time 0
+// objects the mover already overlaps are ignored, so it can always move out of them
+bool SweepRect(Rectangle mover, Vector2 motion, Rectangle object, float* time, Vector2* normal);
+
+// finds the earliest hit between the mover and the listed objects, candidates are indexes into objects
+bool SweepRectAgainstObjects(Rectangle mover, Vector2 motion, const Rectangle* objects, const int* candidates, int candidateCount, SweepHit* hit);
+
+// true if the bottom of the mover is resting on top of one of the objects, candidates are indexes into objects
+bool IsRectOnGround(Rectangle mover, const Rectangle* objects, const int* candidates, int candidateCount);
+
+// moves a rectangle through the objects, stopping at the first hit and sliding along it with what is left of the motion
+// this is repeated up to 3 times, so a mover can slide along a floor and into a wall in the same step
+// motion is changed to how far the mover can really move, and the hit booleans say which sides of objects were hit
+// a mover that ends up resting on an object also sets hitBottom, even if it didn't move down into it this step
+void MoveRectAndSlide(Rectangle mover, const Rectangle* objects, const int* candidates, int candidateCount, Vector2* motion, bool* hitSide, bool* hitTop, bool* hitBottom);
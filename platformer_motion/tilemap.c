@@ -0,0 +1,254 @@
+#include "tilemap.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TILEMAP_HEADER_SIZE 16
+
+// run lengths are stored 7 bits to a byte, 5 bytes is enough for any map that fits in memory
+#define TILEMAP_MAX_RUN_BITS 35
+
+bool InitTileMap(TileMap* map, int width, int height, float tileSize)
+{
+    map->Width = width;
+    map->Height = height;
+    map->TileSize = tileSize;
+
+    size_t words = ((size_t)width * height + 31) / 32;
+    map->Bits = (uint32_t*)calloc(words > 0 ? words : 1, sizeof(uint32_t));
+
+    return map->Bits != NULL;
+}
+
+void FreeTileMap(TileMap* map)
+{
+    free(map->Bits);
+    map->Bits = NULL;
+    map->Width = 0;
+    map->Height = 0;
+}
+
+bool IsTileSolid(const TileMap* map, int x, int y)
+{
+    if (x < 0 || y < 0 || x >= map->Width || y >= map->Height)
+        return true;
+
+    size_t bit = (size_t)y * map->Width + x;
+    return (map->Bits[bit / 32] >> (bit % 32)) & 1;
+}
+
+void SetTileSolid(TileMap* map, int x, int y, bool solid)
+{
+    if (x < 0 || y < 0 || x >= map->Width || y >= map->Height)
+        return;
+
+    size_t bit = (size_t)y * map->Width + x;
+    if (solid)
+        map->Bits[bit / 32] |= 1u << (bit % 32);
+    else
+        map->Bits[bit / 32] &= ~(1u << (bit % 32));
+}
+
+void FillTileRect(TileMap* map, Rectangle rect)
+{
+    int minX = (int)floorf(rect.x / map->TileSize);
+    int minY = (int)floorf(rect.y / map->TileSize);
+    int maxX = (int)ceilf((rect.x + rect.width) / map->TileSize) - 1;
+    int maxY = (int)ceilf((rect.y + rect.height) / map->TileSize) - 1;
+
+    for (int y = minY; y <= maxY; y++)
+    {
+        for (int x = minX; x <= maxX; x++)
+            SetTileSolid(map, x, y, true);
+    }
+}
+
+static void WriteUInt32(unsigned char* data, uint32_t value)
+{
+    data[0] = (unsigned char)(value);
+    data[1] = (unsigned char)(value >> 8);
+    data[2] = (unsigned char)(value >> 16);
+    data[3] = (unsigned char)(value >> 24);
+}
+
+static uint32_t ReadUInt32(const unsigned char* data)
+{
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+bool LoadTileMap(TileMap* map, const char* fileName)
+{
+    int dataSize = 0;
+    unsigned char* data = LoadFileData(fileName, &dataSize);
+    if (!data)
+        return false;
+
+    if (dataSize < TILEMAP_HEADER_SIZE || memcmp(data, "TMAP", 4) != 0)
+    {
+        TraceLog(LOG_WARNING, "TILEMAP: %s is not a tile map", fileName);
+        UnloadFileData(data);
+        return false;
+    }
+
+    int width = (int)ReadUInt32(data + 4);
+    int height = (int)ReadUInt32(data + 8);
+    float tileSize = (float)ReadUInt32(data + 12);
+
+    if (width <= 0 || height <= 0 || !InitTileMap(map, width, height, tileSize))
+    {
+        UnloadFileData(data);
+        return false;
+    }
+
+    size_t tileCount = (size_t)width * height;
+    size_t tile = 0;
+    bool solid = false;
+    int offset = TILEMAP_HEADER_SIZE;
+
+    while (offset < dataSize && tile < tileCount)
+    {
+        // read one run length
+        size_t run = 0;
+        int shift = 0;
+        while (offset < dataSize)
+        {
+            // more bytes than any real run needs means the file is broken, and shifting further would overflow
+            if (shift >= TILEMAP_MAX_RUN_BITS)
+            {
+                TraceLog(LOG_WARNING, "TILEMAP: %s has a bad run length", fileName);
+                FreeTileMap(map);
+                UnloadFileData(data);
+                return false;
+            }
+
+            unsigned char byte = data[offset++];
+            run |= (size_t)(byte & 0x7F) << shift;
+            shift += 7;
+            if (!(byte & 0x80))
+                break;
+        }
+
+        if (run > tileCount - tile)
+            run = tileCount - tile;
+
+        if (solid)
+        {
+            for (size_t i = tile; i < tile + run; i++)
+                map->Bits[i / 32] |= 1u << (i % 32);
+        }
+
+        tile += run;
+        solid = !solid;
+    }
+
+    UnloadFileData(data);
+
+    if (tile != tileCount)
+        TraceLog(LOG_WARNING, "TILEMAP: %s ended early, the rest of the map is empty", fileName);
+
+    return true;
+}
+
+bool SaveTileMap(const TileMap* map, const char* fileName)
+{
+    size_t tileCount = (size_t)map->Width * map->Height;
+
+    // the worst case is a run for every tile, each run is at most 10 bytes
+    size_t capacity = TILEMAP_HEADER_SIZE + 64;
+    size_t size = 0;
+    unsigned char* data = (unsigned char*)malloc(capacity);
+    if (!data)
+        return false;
+
+    memcpy(data, "TMAP", 4);
+    WriteUInt32(data + 4, (uint32_t)map->Width);
+    WriteUInt32(data + 8, (uint32_t)map->Height);
+    WriteUInt32(data + 12, (uint32_t)map->TileSize);
+    size = TILEMAP_HEADER_SIZE;
+
+    bool solid = false;
+    size_t tile = 0;
+    while (tile < tileCount)
+    {
+        size_t run = 0;
+        while (tile + run < tileCount && (((map->Bits[(tile + run) / 32] >> ((tile + run) % 32)) & 1) != 0) == solid)
+            run++;
+
+        if (size + 10 > capacity)
+        {
+            capacity *= 2;
+            unsigned char* grown = (unsigned char*)realloc(data, capacity);
+            if (!grown)
+            {
+                free(data);
+                return false;
+            }
+            data = grown;
+        }
+
+        tile += run;
+        solid = !solid;
+
+        do
+        {
+            unsigned char byte = run & 0x7F;
+            run >>= 7;
+            data[size++] = byte | (run ? 0x80 : 0);
+        } while (run);
+    }
+
+    bool saved = SaveFileData(fileName, data, (int)size);
+    free(data);
+    return saved;
+}
+
+int GatherSolidTiles(const TileMap* map, Rectangle area, Rectangle* tiles, int maxTiles)
+{
+    int minX = (int)floorf(area.x / map->TileSize);
+    int minY = (int)floorf(area.y / map->TileSize);
+    int maxX = (int)floorf((area.x + area.width) / map->TileSize);
+    int maxY = (int)floorf((area.y + area.height) / map->TileSize);
+
+    int count = 0;
+    for (int y = minY; y <= maxY; y++)
+    {
+        for (int x = minX; x <= maxX; x++)
+        {
+            if (!IsTileSolid(map, x, y))
+                continue;
+
+            tiles[count++] = (Rectangle){ x * map->TileSize, y * map->TileSize, map->TileSize, map->TileSize };
+            if (count == maxTiles)
+                return count;
+        }
+    }
+
+    return count;
+}
+
+void DrawTileMap(const TileMap* map, Rectangle view, Color color)
+{
+    int minX = (int)floorf(view.x / map->TileSize);
+    int minY = (int)floorf(view.y / map->TileSize);
+    int maxX = (int)floorf((view.x + view.width) / map->TileSize);
+    int maxY = (int)floorf((view.y + view.height) / map->TileSize);
+
+    if (minX < 0)
+        minX = 0;
+    if (minY < 0)
+        minY = 0;
+    if (maxX >= map->Width)
+        maxX = map->Width - 1;
+    if (maxY >= map->Height)
+        maxY = map->Height - 1;
+
+    for (int y = minY; y <= maxY; y++)
+    {
+        for (int x = minX; x <= maxX; x++)
+        {
+            if (IsTileSolid(map, x, y))
+                DrawRectangleRec((Rectangle){ x * map->TileSize, y * map->TileSize, map->TileSize, map->TileSize }, color);
+        }
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "raylib.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// a level made of square tiles that are either solid or empty, stored as one bit per tile
+// collision only looks at the tiles under a moving rectangle, so it costs the same however big the level is
+// tiles outside of the map count as solid, so the edge of the map is a wall
+
+typedef struct TileMap
+{
+    int Width;      // in tiles
+    int Height;
+    float TileSize; // in pixels
+
+    uint32_t* Bits; // row by row, bit (y * Width + x) is the tile at x,y
+}TileMap;
+
+bool InitTileMap(TileMap* map, int width, int height, float tileSize);
+void FreeTileMap(TileMap* map);
+
+bool IsTileSolid(const TileMap* map, int x, int y);
+void SetTileSolid(TileMap* map, int x, int y, bool solid);
+
+// makes every tile that a rectangle (in pixels) covers solid
+void FillTileRect(TileMap* map, Rectangle rect);
+
+// tile map files are run length encoded, so large open areas and long floors take almost no space
+// the file is "TMAP", then the width, height and tile size as 32 bit little endian integers,
+// then the lengths of the runs of tiles as variable length integers (7 bits a byte, lowest first), alternating empty and solid, starting with empty
+bool LoadTileMap(TileMap* map, const char* fileName);
+bool SaveTileMap(const TileMap* map, const char* fileName);
+
+// fills tiles with a rectangle for each solid tile that overlaps area, returns how many were found, up to maxTiles
+int GatherSolidTiles(const TileMap* map, Rectangle area, Rectangle* tiles, int maxTiles);
+
+// draws the solid tiles that are inside view
+void DrawTileMap(const TileMap* map, Rectangle view, Color color);
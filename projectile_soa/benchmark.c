@@ -0,0 +1,109 @@
+/**********************************************************************************************
+*
+*   raylib-extras, examples-c * examples for Raylib in C
+*
+*   Projectile SoA benchmark * measures how many projectiles each update kernel can move per second, without a window
+*
+*   LICENSE: MIT
+*
+*   Copyright (c) 2024 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+#include "projectiles.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// each size runs roughly the same number of projectile updates, so every result takes about as long to measure
+#define BENCHMARK_UPDATES 200000000.0
+#define BENCHMARK_DELTA_TIME (1.0f / 240.0f)
+
+const int BenchmarkSizes[] = { 1000, 100000, 1000000 };
+
+double GetBenchmarkTime()
+{
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1000000000.0;
+}
+
+float RandomRange(float min, float max)
+{
+    return min + (max - min) * ((float)rand() / (float)RAND_MAX);
+}
+
+// tops the store back up after projectiles expire, so every update works on the same number of them
+void FillProjectiles(ProjectileStore* store)
+{
+    while (AddProjectile(store, RandomRange(0, 1280), RandomRange(0, 800), RandomRange(-300, 300), RandomRange(-300, 300), RandomRange(0.5f, 3.0f)))
+        ;
+}
+
+void RunBenchmark(int count, ProjectileKernel kernel)
+{
+    ProjectileStore store;
+    if (!InitProjectileStore(&store, count))
+    {
+        printf("  out of memory for %d projectiles\n", count);
+        return;
+    }
+
+    srand(1234);
+    FillProjectiles(&store);
+
+    int frames = (int)(BENCHMARK_UPDATES / count);
+
+    double updated = 0;
+    double updateTime = 0;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        updated += store.Count;
+
+        double start = GetBenchmarkTime();
+        UpdateProjectiles(&store, BENCHMARK_DELTA_TIME, kernel);
+        updateTime += GetBenchmarkTime() - start;
+
+        // refilling isn't part of the update, so it isn't timed
+        FillProjectiles(&store);
+    }
+
+    printf("  %-6s %8d projectiles, %7.1f million per second, %8.2f us per update\n", ProjectileKernelNames[kernel], count, updated / updateTime / 1000000.0, updateTime / frames * 1000000.0);
+
+    FreeProjectileStore(&store);
+}
+
+int main()
+{
+    printf("Projectile update benchmark, best kernel on this CPU is %s\n", ProjectileKernelNames[GetBestProjectileKernel()]);
+
+    for (int size = 0; size < sizeof(BenchmarkSizes) / sizeof(BenchmarkSizes[0]); size++)
+    {
+        for (int kernel = 0; kernel < KernelCount; kernel++)
+        {
+            if (ProjectileKernelSupported((ProjectileKernel)kernel))
+                RunBenchmark(BenchmarkSizes[size], (ProjectileKernel)kernel);
+        }
+    }
+
+    return 0;
+}
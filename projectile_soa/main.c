@@ -0,0 +1,123 @@
+/**********************************************************************************************
+*
+*   raylib-extras, examples-c * examples for Raylib in C
+*
+*   Projectile SoA * a bullet hell emitter that updates its projectiles as a structure of arrays with SIMD
+*
+*   LICENSE: MIT
+*
+*   Copyright (c) 2024 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+#include "raylib.h"
+
+#include <math.h>
+
+#include "projectiles.h"
+
+#define MaxProjectiles 200000
+
+const float ProjectileLife = 4.0f;
+const float ProjectileSpeed = 150.0f;
+const int EmitterArms = 24;
+const float EmitterSpin = 40.0f;
+
+ProjectileStore Projectiles = { 0 };
+ProjectileKernel Kernel = ScalarKernel;
+
+int ShotsPerSecond = 2000;
+float EmitterAngle = 0;
+float ShotAccumulator = 0;
+
+void UpdateEmitter(Vector2 center, float deltaTime)
+{
+    EmitterAngle += EmitterSpin * deltaTime;
+
+    // each shot fires one projectile down every arm of the emitter
+    ShotAccumulator += deltaTime * ShotsPerSecond / EmitterArms;
+    while (ShotAccumulator >= 1)
+    {
+        ShotAccumulator -= 1;
+
+        for (int arm = 0; arm < EmitterArms; arm++)
+        {
+            float angle = (EmitterAngle + arm * 360.0f / EmitterArms) * DEG2RAD;
+            AddProjectile(&Projectiles, center.x, center.y, cosf(angle) * ProjectileSpeed, sinf(angle) * ProjectileSpeed, ProjectileLife);
+        }
+    }
+}
+
+void NextKernel()
+{
+    do
+    {
+        Kernel = (ProjectileKernel)((Kernel + 1) % KernelCount);
+    } while (!ProjectileKernelSupported(Kernel));
+}
+
+int main()
+{
+    SetConfigFlags(FLAG_VSYNC_HINT | FLAG_WINDOW_RESIZABLE);
+    InitWindow(1280, 800, "Projectile SoA");
+    SetTargetFPS(144);
+
+    InitProjectileStore(&Projectiles, MaxProjectiles);
+    Kernel = GetBestProjectileKernel();
+
+    while (!WindowShouldClose())
+    {
+        if (IsKeyPressed(KEY_K))
+            NextKernel();
+
+        if (IsKeyPressed(KEY_UP))
+            ShotsPerSecond *= 2;
+        if (IsKeyPressed(KEY_DOWN) && ShotsPerSecond > 250)
+            ShotsPerSecond /= 2;
+
+        // read the frame time once, not once per projectile
+        float deltaTime = GetFrameTime();
+        Vector2 center = { GetScreenWidth() * 0.5f, GetScreenHeight() * 0.5f };
+
+        double updateStart = GetTime();
+        UpdateProjectiles(&Projectiles, deltaTime, Kernel);
+        double updateTime = GetTime() - updateStart;
+
+        UpdateEmitter(center, deltaTime);
+
+        BeginDrawing();
+        ClearBackground(BLACK);
+
+        // all the same size and color, so raylib batches these into as few draw calls as it can
+        for (int i = 0; i < Projectiles.Count; i++)
+            DrawRectangle((int)Projectiles.X[i] - 1, (int)Projectiles.Y[i] - 1, 3, 3, ORANGE);
+
+        DrawFPS(0, 0);
+        DrawText(TextFormat("%d projectiles, %s kernel, update %.3f ms", Projectiles.Count, ProjectileKernelNames[Kernel], updateTime * 1000.0), 2, 20, 20, WHITE);
+        DrawText("K = change kernel Up/Down = fire rate", 2, GetScreenHeight() - 20, 20, GRAY);
+        EndDrawing();
+    }
+
+    FreeProjectileStore(&Projectiles);
+
+    CloseWindow();
+    return 0;
+}
@@ -0,0 +1,45 @@
+baseName = path.getbasename(os.getcwd())
+
+defineWorkspace(baseName)
+    project (baseName)
+        kind "ConsoleApp"
+        location "_build"
+        targetdir "_bin/%{cfg.buildcfg}"
+
+        filter "action:vs*"
+            debugdir "$(SolutionDir)"
+
+        filter {"action:vs*", "configurations:Release"}
+            kind "WindowedApp"
+            entrypoint "mainCRTStartup"
+            
+        filter{}
+
+        vpaths 
+        {
+            ["Header Files/*"] = { "include/**.h",  "include/**.hpp", "src/**.h", "src/**.hpp", "**.h", "**.hpp"},
+            ["Source Files/*"] = {"src/**.c", "src/**.cpp","**.c", "**.cpp"},
+        }
+        files {"**.c", "**.cpp", "**.h", "**.hpp"}
+        removefiles {"benchmark.c"}
+
+        includedirs { "./"}
+        includedirs { "./include"}
+        includedirs { "./src"}
+        link_raylib();
+
+    -- the benchmark doesn't open a window, so it doesn't need raylib
+    project (baseName .. "_benchmark")
+        kind "ConsoleApp"
+        location "_build"
+        targetdir "_bin/%{cfg.buildcfg}"
+        language "C"
+
+        filter "action:vs*"
+            debugdir "$(SolutionDir)"
+
+        filter{}
+
+        files {"benchmark.c", "projectiles.c", "projectiles.h"}
+
+        includedirs { "./"}
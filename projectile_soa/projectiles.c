@@ -0,0 +1,328 @@
+#include "projectiles.h"
+
+#include <stdlib.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PROJECTILES_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define PROJECTILES_NEON
+#include <arm_neon.h>
+#endif
+
+// gcc and clang need to be told a function may use AVX2, msvc allows the intrinsics anywhere
+#if defined(PROJECTILES_X86) && (defined(__GNUC__) || defined(__clang__))
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#else
+#define AVX2_FUNCTION
+#endif
+
+const char* ProjectileKernelNames[KernelCount] = { "Scalar", "SSE", "AVX2", "NEON" };
+
+bool InitProjectileStore(ProjectileStore* store, int capacity)
+{
+    store->Count = 0;
+    store->Capacity = capacity;
+
+    store->X = (float*)malloc(sizeof(float) * capacity);
+    store->Y = (float*)malloc(sizeof(float) * capacity);
+    store->VX = (float*)malloc(sizeof(float) * capacity);
+    store->VY = (float*)malloc(sizeof(float) * capacity);
+    store->Life = (float*)malloc(sizeof(float) * capacity);
+
+    if (!store->X || !store->Y || !store->VX || !store->VY || !store->Life)
+    {
+        FreeProjectileStore(store);
+        return false;
+    }
+
+    return true;
+}
+
+void FreeProjectileStore(ProjectileStore* store)
+{
+    free(store->X);
+    free(store->Y);
+    free(store->VX);
+    free(store->VY);
+    free(store->Life);
+
+    store->X = store->Y = store->VX = store->VY = store->Life = NULL;
+    store->Count = 0;
+    store->Capacity = 0;
+}
+
+bool AddProjectile(ProjectileStore* store, float x, float y, float vx, float vy, float life)
+{
+    if (store->Count >= store->Capacity)
+        return false;
+
+    int i = store->Count++;
+    store->X[i] = x;
+    store->Y[i] = y;
+    store->VX[i] = vx;
+    store->VY[i] = vy;
+    store->Life[i] = life;
+    return true;
+}
+
+bool ProjectileKernelSupported(ProjectileKernel kernel)
+{
+    switch (kernel)
+    {
+    case ScalarKernel:
+        return true;
+
+#if defined(PROJECTILES_X86)
+    case SSEKernel:
+        return true; // every x64 CPU has SSE2, and so does anything that can run raylib on x86
+
+    case AVX2Kernel:
+#if defined(_MSC_VER)
+    {
+        // the CPU has to support AVX2, and the OS has to save the AVX registers
+        int info[4];
+        __cpuid(info, 1);
+        bool osSavesAVX = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        return osSavesAVX && (info[1] & (1 << 5));
+    }
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+#endif
+
+#if defined(PROJECTILES_NEON)
+    case NEONKernel:
+        return true;
+#endif
+
+    default:
+        return false;
+    }
+}
+
+ProjectileKernel GetBestProjectileKernel()
+{
+    for (int kernel = KernelCount - 1; kernel > ScalarKernel; kernel--)
+    {
+        if (ProjectileKernelSupported((ProjectileKernel)kernel))
+            return (ProjectileKernel)kernel;
+    }
+
+    return ScalarKernel;
+}
+
+// moves one projectile from 'from' to 'to', the same as the vector kernels do for each lane
+static int UpdateProjectileScalar(ProjectileStore* store, int from, int to, float deltaTime)
+{
+    float life = store->Life[from] - deltaTime;
+
+    // written as not greater than, so a NaN life is dropped the same as the vector kernels' compare drops it
+    if (!(life > 0))
+        return to;
+
+    store->X[to] = store->X[from] + store->VX[from] * deltaTime;
+    store->Y[to] = store->Y[from] + store->VY[from] * deltaTime;
+    store->VX[to] = store->VX[from];
+    store->VY[to] = store->VY[from];
+    store->Life[to] = life;
+    return to + 1;
+}
+
+// the vector kernels do a block of projectiles at a time
+// if the whole block survives, it is written straight to where the survivors end, which is where it already is until something dies
+// if any of the block dies, the block is written to a scratch buffer and the survivors are copied out one at a time
+// writes never pass reads, so this works in place
+static int PackBlock(ProjectileStore* store, int to, int width, int aliveMask, const float* x, const float* y, const float* vx, const float* vy, const float* life)
+{
+    for (int lane = 0; lane < width; lane++)
+    {
+        if (!(aliveMask & (1 << lane)))
+            continue;
+
+        store->X[to] = x[lane];
+        store->Y[to] = y[lane];
+        store->VX[to] = vx[lane];
+        store->VY[to] = vy[lane];
+        store->Life[to] = life[lane];
+        to++;
+    }
+    return to;
+}
+
+static int UpdateScalar(ProjectileStore* store, float deltaTime)
+{
+    int to = 0;
+    for (int from = 0; from < store->Count; from++)
+        to = UpdateProjectileScalar(store, from, to, deltaTime);
+
+    return to;
+}
+
+#if defined(PROJECTILES_X86)
+static int UpdateSSE(ProjectileStore* store, float deltaTime)
+{
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 zero = _mm_setzero_ps();
+
+    int to = 0;
+    int from = 0;
+    for (; from + 4 <= store->Count; from += 4)
+    {
+        __m128 vx = _mm_loadu_ps(store->VX + from);
+        __m128 vy = _mm_loadu_ps(store->VY + from);
+        __m128 x = _mm_add_ps(_mm_loadu_ps(store->X + from), _mm_mul_ps(vx, dt));
+        __m128 y = _mm_add_ps(_mm_loadu_ps(store->Y + from), _mm_mul_ps(vy, dt));
+        __m128 life = _mm_sub_ps(_mm_loadu_ps(store->Life + from), dt);
+
+        int aliveMask = _mm_movemask_ps(_mm_cmpgt_ps(life, zero));
+        if (aliveMask == 0xF)
+        {
+            _mm_storeu_ps(store->X + to, x);
+            _mm_storeu_ps(store->Y + to, y);
+            _mm_storeu_ps(store->VX + to, vx);
+            _mm_storeu_ps(store->VY + to, vy);
+            _mm_storeu_ps(store->Life + to, life);
+            to += 4;
+        }
+        else if (aliveMask != 0)
+        {
+            float blockX[4], blockY[4], blockVX[4], blockVY[4], blockLife[4];
+            _mm_storeu_ps(blockX, x);
+            _mm_storeu_ps(blockY, y);
+            _mm_storeu_ps(blockVX, vx);
+            _mm_storeu_ps(blockVY, vy);
+            _mm_storeu_ps(blockLife, life);
+            to = PackBlock(store, to, 4, aliveMask, blockX, blockY, blockVX, blockVY, blockLife);
+        }
+    }
+
+    for (; from < store->Count; from++)
+        to = UpdateProjectileScalar(store, from, to, deltaTime);
+
+    return to;
+}
+
+AVX2_FUNCTION static int UpdateAVX2(ProjectileStore* store, float deltaTime)
+{
+    const __m256 dt = _mm256_set1_ps(deltaTime);
+    const __m256 zero = _mm256_setzero_ps();
+
+    int to = 0;
+    int from = 0;
+    for (; from + 8 <= store->Count; from += 8)
+    {
+        __m256 vx = _mm256_loadu_ps(store->VX + from);
+        __m256 vy = _mm256_loadu_ps(store->VY + from);
+        __m256 x = _mm256_add_ps(_mm256_loadu_ps(store->X + from), _mm256_mul_ps(vx, dt));
+        __m256 y = _mm256_add_ps(_mm256_loadu_ps(store->Y + from), _mm256_mul_ps(vy, dt));
+        __m256 life = _mm256_sub_ps(_mm256_loadu_ps(store->Life + from), dt);
+
+        int aliveMask = _mm256_movemask_ps(_mm256_cmp_ps(life, zero, _CMP_GT_OQ));
+        if (aliveMask == 0xFF)
+        {
+            _mm256_storeu_ps(store->X + to, x);
+            _mm256_storeu_ps(store->Y + to, y);
+            _mm256_storeu_ps(store->VX + to, vx);
+            _mm256_storeu_ps(store->VY + to, vy);
+            _mm256_storeu_ps(store->Life + to, life);
+            to += 8;
+        }
+        else if (aliveMask != 0)
+        {
+            float blockX[8], blockY[8], blockVX[8], blockVY[8], blockLife[8];
+            _mm256_storeu_ps(blockX, x);
+            _mm256_storeu_ps(blockY, y);
+            _mm256_storeu_ps(blockVX, vx);
+            _mm256_storeu_ps(blockVY, vy);
+            _mm256_storeu_ps(blockLife, life);
+            to = PackBlock(store, to, 8, aliveMask, blockX, blockY, blockVX, blockVY, blockLife);
+        }
+    }
+
+    for (; from < store->Count; from++)
+        to = UpdateProjectileScalar(store, from, to, deltaTime);
+
+    return to;
+}
+#endif
+
+#if defined(PROJECTILES_NEON)
+static int UpdateNEON(ProjectileStore* store, float deltaTime)
+{
+    const float32x4_t dt = vdupq_n_f32(deltaTime);
+    const float32x4_t zero = vdupq_n_f32(0);
+    const uint32x4_t laneBits = { 1, 2, 4, 8 };
+
+    int to = 0;
+    int from = 0;
+    for (; from + 4 <= store->Count; from += 4)
+    {
+        float32x4_t vx = vld1q_f32(store->VX + from);
+        float32x4_t vy = vld1q_f32(store->VY + from);
+        // multiply then add, rather than vfmaq, so the results match the other kernels
+        float32x4_t x = vaddq_f32(vld1q_f32(store->X + from), vmulq_f32(vx, dt));
+        float32x4_t y = vaddq_f32(vld1q_f32(store->Y + from), vmulq_f32(vy, dt));
+        float32x4_t life = vsubq_f32(vld1q_f32(store->Life + from), dt);
+
+        uint32x4_t alive = vandq_u32(vcgtq_f32(life, zero), laneBits);
+        int aliveMask = (int)(vgetq_lane_u32(alive, 0) | vgetq_lane_u32(alive, 1) | vgetq_lane_u32(alive, 2) | vgetq_lane_u32(alive, 3));
+        if (aliveMask == 0xF)
+        {
+            vst1q_f32(store->X + to, x);
+            vst1q_f32(store->Y + to, y);
+            vst1q_f32(store->VX + to, vx);
+            vst1q_f32(store->VY + to, vy);
+            vst1q_f32(store->Life + to, life);
+            to += 4;
+        }
+        else if (aliveMask != 0)
+        {
+            float blockX[4], blockY[4], blockVX[4], blockVY[4], blockLife[4];
+            vst1q_f32(blockX, x);
+            vst1q_f32(blockY, y);
+            vst1q_f32(blockVX, vx);
+            vst1q_f32(blockVY, vy);
+            vst1q_f32(blockLife, life);
+            to = PackBlock(store, to, 4, aliveMask, blockX, blockY, blockVX, blockVY, blockLife);
+        }
+    }
+
+    for (; from < store->Count; from++)
+        to = UpdateProjectileScalar(store, from, to, deltaTime);
+
+    return to;
+}
+#endif
+
+void UpdateProjectiles(ProjectileStore* store, float deltaTime, ProjectileKernel kernel)
+{
+    if (!ProjectileKernelSupported(kernel))
+        kernel = ScalarKernel;
+
+    switch (kernel)
+    {
+#if defined(PROJECTILES_X86)
+    case SSEKernel:
+        store->Count = UpdateSSE(store, deltaTime);
+        break;
+    case AVX2Kernel:
+        store->Count = UpdateAVX2(store, deltaTime);
+        break;
+#endif
+#if defined(PROJECTILES_NEON)
+    case NEONKernel:
+        store->Count = UpdateNEON(store, deltaTime);
+        break;
+#endif
+    default:
+        store->Count = UpdateScalar(store, deltaTime);
+        break;
+    }
+}
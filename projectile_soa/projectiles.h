@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdbool.h>
+
+// projectiles stored as a structure of arrays, so the update can work on several of them at once with SIMD
+// each field has its own array, and live projectiles are always packed at the front
+// the update moves every projectile, ages it, and removes the ones that run out of life in the same pass
+// removal keeps the order of the survivors, so projectiles that were fired first stay first
+
+typedef struct ProjectileStore
+{
+    int Count;
+    int Capacity;
+
+    float* X;
+    float* Y;
+    float* VX;
+    float* VY;
+    float* Life;
+}ProjectileStore;
+
+// the update kernels, which ones are available depends on the CPU and how the code was built
+typedef enum
+{
+    ScalarKernel = 0,
+    SSEKernel,
+    AVX2Kernel,
+    NEONKernel,
+    KernelCount,
+}ProjectileKernel;
+
+extern const char* ProjectileKernelNames[KernelCount];
+
+bool InitProjectileStore(ProjectileStore* store, int capacity);
+void FreeProjectileStore(ProjectileStore* store);
+
+// returns false when the store is full
+bool AddProjectile(ProjectileStore* store, float x, float y, float vx, float vy, float life);
+
+bool ProjectileKernelSupported(ProjectileKernel kernel);
+
+// the fastest kernel this CPU supports
+ProjectileKernel GetBestProjectileKernel();
+
+// moves every projectile by its velocity * deltaTime, takes deltaTime off its life, and removes any that have no life left
+void UpdateProjectiles(ProjectileStore* store, float deltaTime, ProjectileKernel kernel);
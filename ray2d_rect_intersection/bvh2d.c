@@ -0,0 +1,373 @@
+#include "bvh2d.h"
+#include "ray2d.h"
+
+#include "raymath.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BVH_BINS 16
+
+// node bounds are tested slightly bigger than they are, a ray that only grazes a shape can count as a hit by the shape's own test
+// while rounding puts it just outside the bounds, the margin keeps the tree from skipping those
+#define BVH_NODE_MARGIN 0.01f
+#define BVH_MAX_LEAF_SHAPES 4
+
+// nodes this deep stay leaves, so a query's stack can never overflow
+#define BVH_MAX_DEPTH 62
+#define BVH_STACK_SIZE (BVH_MAX_DEPTH + 2)
+
+Rectangle GetBVHShapeBounds(const BVHShape* shape)
+{
+    if (shape->Type == BVHShapeCircle)
+        return (Rectangle){ shape->Center.x - shape->Radius, shape->Center.y - shape->Radius, shape->Radius * 2, shape->Radius * 2 };
+
+    return shape->Rect;
+}
+
+bool RayIntersectBVHShape(const BVHShape* shape, Vector2 origin, Vector2 direction, float* distance)
+{
+    Vector2 point = { 0, 0 };
+    bool hit = false;
+    if (shape->Type == BVHShapeCircle)
+        hit = CheckCollisionRay2dCircle((Ray2d) { origin, direction }, shape->Center, shape->Radius, &point);
+    else
+        hit = RayIntersectRect(shape->Rect, origin, direction, &point);
+
+    if (!hit)
+        return false;
+
+    // the rectangle test gives a point behind the origin when the ray starts inside, count that as a hit right away
+    *distance = fmaxf(Vector2DotProduct(Vector2Subtract(point, origin), direction), 0.0f);
+    return true;
+}
+
+// the 2d version of surface area, the chance a random ray hits a box goes with its perimeter
+static float HalfPerimeter(float minX, float minY, float maxX, float maxY)
+{
+    return (maxX - minX) + (maxY - minY);
+}
+
+static void GrowBounds(float* minX, float* minY, float* maxX, float* maxY, Rectangle rect)
+{
+    *minX = fminf(*minX, rect.x);
+    *minY = fminf(*minY, rect.y);
+    *maxX = fmaxf(*maxX, rect.x + rect.width);
+    *maxY = fmaxf(*maxY, rect.y + rect.height);
+}
+
+static void SetNodeBounds(BVH* bvh, BVHNode* node, const Rectangle* bounds)
+{
+    node->MinX = node->MinY = INFINITY;
+    node->MaxX = node->MaxY = -INFINITY;
+    for (int i = node->Start; i < node->Start + node->Count; i++)
+        GrowBounds(&node->MinX, &node->MinY, &node->MaxX, &node->MaxY, bounds[bvh->ShapeOrder[i]]);
+}
+
+typedef struct
+{
+    int Count;
+    float MinX, MinY, MaxX, MaxY;
+}BVHBin;
+
+static int GetBin(float centroid, float min, float binScale)
+{
+    int bin = (int)((centroid - min) * binScale);
+    return bin < 0 ? 0 : (bin >= BVH_BINS ? BVH_BINS - 1 : bin);
+}
+
+// splits a node into two children, then splits them, until a split would not make rays cheaper
+static void SplitNode(BVH* bvh, int nodeIndex, int depth, const Rectangle* bounds, const Vector2* centroids)
+{
+    BVHNode* node = &bvh->Nodes[nodeIndex];
+    if (node->Count <= 1 || depth >= BVH_MAX_DEPTH)
+        return;
+
+    // split along the axis the centers are most spread out on
+    float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+    for (int i = node->Start; i < node->Start + node->Count; i++)
+    {
+        Vector2 centroid = centroids[bvh->ShapeOrder[i]];
+        GrowBounds(&minX, &minY, &maxX, &maxY, (Rectangle) { centroid.x, centroid.y, 0, 0 });
+    }
+
+    bool splitX = (maxX - minX) >= (maxY - minY);
+    float min = splitX ? minX : minY;
+    float extent = splitX ? maxX - minX : maxY - minY;
+
+    // every shape has the same center, there is no way to split them
+    if (extent <= 0)
+        return;
+
+    float binScale = BVH_BINS / extent;
+
+    BVHBin bins[BVH_BINS];
+    for (int bin = 0; bin < BVH_BINS; bin++)
+        bins[bin] = (BVHBin){ 0, INFINITY, INFINITY, -INFINITY, -INFINITY };
+
+    for (int i = node->Start; i < node->Start + node->Count; i++)
+    {
+        int shape = bvh->ShapeOrder[i];
+        BVHBin* bin = &bins[GetBin(splitX ? centroids[shape].x : centroids[shape].y, min, binScale)];
+        bin->Count++;
+        GrowBounds(&bin->MinX, &bin->MinY, &bin->MaxX, &bin->MaxY, bounds[shape]);
+    }
+
+    // sweep from the right to get the cost of everything past each split, then from the left to find the cheapest
+    float rightCost[BVH_BINS];
+    float rMinX = INFINITY, rMinY = INFINITY, rMaxX = -INFINITY, rMaxY = -INFINITY;
+    int rightCount = 0;
+    for (int bin = BVH_BINS - 1; bin > 0; bin--)
+    {
+        rightCount += bins[bin].Count;
+        if (bins[bin].Count > 0)
+            GrowBounds(&rMinX, &rMinY, &rMaxX, &rMaxY, (Rectangle) { bins[bin].MinX, bins[bin].MinY, bins[bin].MaxX - bins[bin].MinX, bins[bin].MaxY - bins[bin].MinY });
+        rightCost[bin] = rightCount > 0 ? rightCount * HalfPerimeter(rMinX, rMinY, rMaxX, rMaxY) : 0;
+    }
+
+    float bestCost = INFINITY;
+    int bestSplit = -1;
+    float lMinX = INFINITY, lMinY = INFINITY, lMaxX = -INFINITY, lMaxY = -INFINITY;
+    int leftCount = 0;
+    for (int bin = 0; bin < BVH_BINS - 1; bin++)
+    {
+        leftCount += bins[bin].Count;
+        if (bins[bin].Count > 0)
+            GrowBounds(&lMinX, &lMinY, &lMaxX, &lMaxY, (Rectangle) { bins[bin].MinX, bins[bin].MinY, bins[bin].MaxX - bins[bin].MinX, bins[bin].MaxY - bins[bin].MinY });
+
+        // both sides need something in them
+        if (leftCount == 0 || leftCount == node->Count)
+            continue;
+
+        float cost = leftCount * HalfPerimeter(lMinX, lMinY, lMaxX, lMaxY) + rightCost[bin + 1];
+        if (cost < bestCost)
+        {
+            bestCost = cost;
+            bestSplit = bin;
+        }
+    }
+
+    // small nodes stay leaves unless splitting is cheaper than testing every shape in them
+    float leafCost = node->Count * HalfPerimeter(node->MinX, node->MinY, node->MaxX, node->MaxY);
+    if (bestSplit < 0 || (node->Count <= BVH_MAX_LEAF_SHAPES && bestCost >= leafCost))
+        return;
+
+    // move the shapes on the left of the split to the front of the node's range
+    int left = node->Start;
+    int right = node->Start + node->Count - 1;
+    while (left <= right)
+    {
+        int shape = bvh->ShapeOrder[left];
+        if (GetBin(splitX ? centroids[shape].x : centroids[shape].y, min, binScale) <= bestSplit)
+        {
+            left++;
+        }
+        else
+        {
+            bvh->ShapeOrder[left] = bvh->ShapeOrder[right];
+            bvh->ShapeOrder[right] = shape;
+            right--;
+        }
+    }
+
+    int leftChild = bvh->NodeCount;
+    bvh->NodeCount += 2;
+
+    BVHNode* leftNode = &bvh->Nodes[leftChild];
+    BVHNode* rightNode = &bvh->Nodes[leftChild + 1];
+    leftNode->Start = node->Start;
+    leftNode->Count = left - node->Start;
+    rightNode->Start = left;
+    rightNode->Count = node->Count - leftNode->Count;
+    SetNodeBounds(bvh, leftNode, bounds);
+    SetNodeBounds(bvh, rightNode, bounds);
+
+    node->Start = leftChild;
+    node->Count = 0;
+
+    SplitNode(bvh, leftChild, depth + 1, bounds, centroids);
+    SplitNode(bvh, leftChild + 1, depth + 1, bounds, centroids);
+}
+
+bool BuildBVH(BVH* bvh, const BVHShape* shapes, int count)
+{
+    memset(bvh, 0, sizeof(BVH));
+    bvh->Shapes = shapes;
+    bvh->ShapeCount = count;
+
+    // a binary tree with one shape per leaf has at most 2n - 1 nodes
+    int maxNodes = count > 0 ? count * 2 - 1 : 1;
+    bvh->Nodes = (BVHNode*)malloc(sizeof(BVHNode) * maxNodes);
+    bvh->ShapeOrder = (int*)malloc(sizeof(int) * (count > 0 ? count : 1));
+
+    Rectangle* bounds = (Rectangle*)malloc(sizeof(Rectangle) * (count > 0 ? count : 1));
+    Vector2* centroids = (Vector2*)malloc(sizeof(Vector2) * (count > 0 ? count : 1));
+
+    if (!bvh->Nodes || !bvh->ShapeOrder || !bounds || !centroids)
+    {
+        free(bounds);
+        free(centroids);
+        FreeBVH(bvh);
+        return false;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        bvh->ShapeOrder[i] = i;
+        bounds[i] = GetBVHShapeBounds(&shapes[i]);
+        centroids[i] = (Vector2){ bounds[i].x + bounds[i].width * 0.5f, bounds[i].y + bounds[i].height * 0.5f };
+    }
+
+    bvh->NodeCount = 1;
+    bvh->Nodes[0].Start = 0;
+    bvh->Nodes[0].Count = count;
+    SetNodeBounds(bvh, &bvh->Nodes[0], bounds);
+
+    SplitNode(bvh, 0, 0, bounds, centroids);
+
+    free(bounds);
+    free(centroids);
+    return true;
+}
+
+void FreeBVH(BVH* bvh)
+{
+    free(bvh->Nodes);
+    free(bvh->ShapeOrder);
+    memset(bvh, 0, sizeof(BVH));
+}
+
+void RefitBVH(BVH* bvh)
+{
+    // an empty tree is just the root with no shapes, which would otherwise look like an interior node
+    if (bvh->ShapeCount == 0)
+        return;
+
+    // children are always added after their parent, so walking backwards updates them first
+    for (int i = bvh->NodeCount - 1; i >= 0; i--)
+    {
+        BVHNode* node = &bvh->Nodes[i];
+        node->MinX = node->MinY = INFINITY;
+        node->MaxX = node->MaxY = -INFINITY;
+
+        if (node->Count > 0)
+        {
+            for (int shape = node->Start; shape < node->Start + node->Count; shape++)
+                GrowBounds(&node->MinX, &node->MinY, &node->MaxX, &node->MaxY, GetBVHShapeBounds(&bvh->Shapes[bvh->ShapeOrder[shape]]));
+            continue;
+        }
+
+        for (int child = node->Start; child <= node->Start + 1; child++)
+        {
+            const BVHNode* childNode = &bvh->Nodes[child];
+            node->MinX = fminf(node->MinX, childNode->MinX);
+            node->MinY = fminf(node->MinY, childNode->MinY);
+            node->MaxX = fmaxf(node->MaxX, childNode->MaxX);
+            node->MaxY = fmaxf(node->MaxY, childNode->MaxY);
+        }
+    }
+}
+
+// the distance the ray enters a node's bounds, or INFINITY if it misses or the node is past maxDistance
+static float RayEnterNode(const BVHNode* node, Vector2 origin, Vector2 inverseDirection, float maxDistance)
+{
+    float tx1 = (node->MinX - BVH_NODE_MARGIN - origin.x) * inverseDirection.x;
+    float tx2 = (node->MaxX + BVH_NODE_MARGIN - origin.x) * inverseDirection.x;
+    float ty1 = (node->MinY - BVH_NODE_MARGIN - origin.y) * inverseDirection.y;
+    float ty2 = (node->MaxY + BVH_NODE_MARGIN - origin.y) * inverseDirection.y;
+
+    // starting exactly on an edge gives 0 * infinity, the nan is dropped by fminf and fmaxf so the node still counts as hit
+    float enter = fmaxf(fmaxf(fminf(tx1, tx2), fminf(ty1, ty2)), 0.0f);
+    float exit = fminf(fmaxf(tx1, tx2), fmaxf(ty1, ty2));
+
+    if (enter > exit || enter > maxDistance)
+        return INFINITY;
+
+    return enter;
+}
+
+static bool CastRay(const BVH* bvh, Vector2 origin, Vector2 direction, float maxDistance, bool anyHit, BVHHit* hit)
+{
+    if (bvh->ShapeCount == 0)
+        return false;
+
+    Vector2 inverseDirection = { 1.0f / direction.x, 1.0f / direction.y };
+
+    float nearest = maxDistance;
+    int nearestShape = -1;
+
+    int stack[BVH_STACK_SIZE];
+    int stackSize = 0;
+
+    if (RayEnterNode(&bvh->Nodes[0], origin, inverseDirection, nearest) != INFINITY)
+        stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const BVHNode* node = &bvh->Nodes[stack[--stackSize]];
+
+        if (node->Count > 0)
+        {
+            for (int i = node->Start; i < node->Start + node->Count; i++)
+            {
+                int shape = bvh->ShapeOrder[i];
+                float distance = 0;
+                if (!RayIntersectBVHShape(&bvh->Shapes[shape], origin, direction, &distance) || distance > nearest)
+                    continue;
+
+                // on a tie the lowest shape wins, the same as testing every shape in order
+                if (distance < nearest || nearestShape < 0 || shape < nearestShape)
+                {
+                    nearest = distance;
+                    nearestShape = shape;
+                }
+
+                if (anyHit)
+                    return true;
+            }
+            continue;
+        }
+
+        // push the further child first, so the nearer one is tested first and shrinks nearest for the other
+        float leftEnter = RayEnterNode(&bvh->Nodes[node->Start], origin, inverseDirection, nearest);
+        float rightEnter = RayEnterNode(&bvh->Nodes[node->Start + 1], origin, inverseDirection, nearest);
+
+        int first = node->Start;
+        int second = node->Start + 1;
+        if (rightEnter < leftEnter)
+        {
+            first = node->Start + 1;
+            second = node->Start;
+            float swap = leftEnter;
+            leftEnter = rightEnter;
+            rightEnter = swap;
+        }
+
+        if (rightEnter != INFINITY)
+            stack[stackSize++] = second;
+        if (leftEnter != INFINITY)
+            stack[stackSize++] = first;
+    }
+
+    if (nearestShape < 0)
+        return false;
+
+    if (hit)
+    {
+        hit->Shape = nearestShape;
+        hit->Distance = nearest;
+        hit->Point = Vector2Add(origin, Vector2Scale(direction, nearest));
+    }
+    return true;
+}
+
+bool RaycastBVH(const BVH* bvh, Vector2 origin, Vector2 direction, float maxDistance, BVHHit* hit)
+{
+    return CastRay(bvh, origin, direction, maxDistance, false, hit);
+}
+
+bool RayHitsAnyBVH(const BVH* bvh, Vector2 origin, Vector2 direction, float maxDistance)
+{
+    return CastRay(bvh, origin, direction, maxDistance, true, NULL);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "raylib.h"
+
+#include <stdbool.h>
+
+// a bounding volume hierarchy over rectangles and circles, so a ray only has to test the shapes near its path
+// the tree is built with binned SAH splits and stored flat, the two children of a node are always next to each other
+// the leaves test shapes with RayIntersectRect and CheckCollisionRay2dCircle
+
+typedef enum
+{
+    BVHShapeRect = 0,
+    BVHShapeCircle,
+}BVHShapeType;
+
+typedef struct BVHShape
+{
+    BVHShapeType Type;
+    Rectangle Rect;     // used by rectangles
+    Vector2 Center;     // used by circles
+    float Radius;
+}BVHShape;
+
+typedef struct BVHNode
+{
+    float MinX;
+    float MinY;
+    float MaxX;
+    float MaxY;
+
+    // a leaf holds Count shapes from ShapeOrder[Start], any other node has Count 0 and its children at Start and Start + 1
+    int Start;
+    int Count;
+}BVHNode;
+
+typedef struct BVH
+{
+    const BVHShape* Shapes;
+    int ShapeCount;
+
+    BVHNode* Nodes;
+    int NodeCount;
+
+    int* ShapeOrder;
+}BVH;
+
+typedef struct BVHHit
+{
+    int Shape;
+    float Distance;
+    Vector2 Point;
+}BVHHit;
+
+// the tree keeps a pointer to shapes, so they must not move while it is used
+bool BuildBVH(BVH* bvh, const BVHShape* shapes, int count);
+void FreeBVH(BVH* bvh);
+
+// updates the bounds of every node after the shapes have moved, without changing the tree
+// this is much faster than a rebuild, but the tree gets slower to query the further the shapes move from where they were built
+void RefitBVH(BVH* bvh);
+
+// finds the nearest shape the ray hits within maxDistance, the direction must be normalized
+// a ray that starts inside a shape hits it at a distance of 0
+bool RaycastBVH(const BVH* bvh, Vector2 origin, Vector2 direction, float maxDistance, BVHHit* hit);
+
+// true if the ray hits anything within maxDistance, stopping at the first hit found, for things like line of sight
+bool RayHitsAnyBVH(const BVH* bvh, Vector2 origin, Vector2 direction, float maxDistance);
+
+Rectangle GetBVHShapeBounds(const BVHShape* shape);
+
+// tests one shape the same way the leaves do, for comparing against testing every shape
+bool RayIntersectBVHShape(const BVHShape* shape, Vector2 origin, Vector2 direction, float* distance);
@@ -0,0 +1,97 @@
+#include "ray2d.h"
+
+#include "raymath.h"
+
+#include <stdlib.h>
+
+// intersection using the slab method
+// https://tavianator.com/2011/ray_box.html#:~:text=The%20fastest%20method%20for%20performing,remains%2C%20it%20intersected%20the%20box.
+
+bool RayIntersectRect(Rectangle rect, Vector2 origin, Vector2 direction, Vector2* point)
+{
+	float minParam = -INFINITY, maxParam = INFINITY;
+
+	if (direction.x != 0.0)
+	{
+		float txMin = (rect.x - origin.x) / direction.x;
+		float txMax = ((rect.x + rect.width) - origin.x) / direction.x;
+
+		minParam = fmaxf(minParam, fminf(txMin, txMax));
+		maxParam = fminf(maxParam, fmaxf(txMin, txMax));
+	}
+	else if (origin.x < rect.x || origin.x > rect.x + rect.width)
+	{
+		// parallel to the slab and outside it, so it can never hit
+		return false;
+	}
+
+	if (direction.y != 0.0)
+	{
+		float tyMin = (rect.y - origin.y) / direction.y;
+		float tyMax = ((rect.y + rect.height) - origin.y) / direction.y;
+
+		minParam = fmaxf(minParam, fminf(tyMin, tyMax));
+		maxParam = fminf(maxParam, fmaxf(tyMin, tyMax));
+	}
+	else if (origin.y < rect.y || origin.y > rect.y + rect.height)
+	{
+		return false;
+	}
+
+	// if maxParam < 0, ray is intersecting AABB, but the whole AABB is behind us
+	if (maxParam < 0)
+	{
+		return false;
+	}
+
+	// if minParam > maxParam, ray doesn't intersect AABB
+	if (minParam > maxParam)
+	{
+		return false;
+	}
+
+	if (point != NULL)
+	{
+		*point = Vector2Add(origin, Vector2Scale(direction, minParam));
+	}
+	return true;
+}
+
+bool CheckCollisionRay2dCircle(Ray2d ray, Vector2 center, float radius, Vector2* intersection)
+{
+	if (CheckCollisionPointCircle(ray.Origin, center, radius))
+	{
+		if (intersection)
+			*intersection = ray.Origin;
+
+		return true;
+	}
+
+	Vector2 vecToCenter = Vector2Subtract(center, ray.Origin);
+	float dot = Vector2DotProduct(vecToCenter, ray.Direction);
+
+	if (dot < 0)
+		return false;
+
+	Vector2 nearest = Vector2Add(ray.Origin, Vector2Scale(ray.Direction, dot));
+
+	Vector2 nearestToCenter = Vector2Subtract(center, nearest);
+	float distSq = Vector2LengthSqr(nearestToCenter);
+
+	if (distSq <= radius * radius)
+	{
+		if (intersection)
+		{
+			float nearestDist = Vector2Length(Vector2Subtract(center, nearest));
+
+			float b = sqrtf(radius * radius - nearestDist * nearestDist);
+
+			*intersection = (Vector2){ ray.Origin.x + ray.Direction.x * (dot - b), ray.Origin.y + ray.Direction.y * (dot - b) };
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
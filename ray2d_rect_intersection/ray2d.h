@@ -0,0 +1,17 @@
+#pragma once
+
+#include "raylib.h"
+
+#include <stdbool.h>
+
+typedef struct
+{
+	Vector2 Origin;
+	Vector2 Direction;
+}Ray2d;
+
+// the point is where the ray enters the rectangle, if the ray starts inside it is behind the origin
+bool RayIntersectRect(Rectangle rect, Vector2 origin, Vector2 direction, Vector2* point);
+
+// the direction must be normalized
+bool CheckCollisionRay2dCircle(Ray2d ray, Vector2 center, float radius, Vector2* intersection);
@@ -19,97 +19,305 @@
 #include "raymath.h"
 #include "stdlib.h"
 
-// intersection using the slab method
-// https://tavianator.com/2011/ray_box.html#:~:text=The%20fastest%20method%20for%20performing,remains%2C%20it%20intersected%20the%20box.
+#include "bvh2d.h"
+#include "ray2d.h"
+#include "ray_batch.h"
 
-bool RayIntersectRect(Rectangle rect, Vector2 origin, Vector2 direction, Vector2* point)
-{
-	float minParam = -INFINITY, maxParam = INFINITY;
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// ray fan
+// many rays cast at once against a field of rectangles, using the batched slab test
+#define FAN_RAYS 2048
+#define FAN_RECTS 200
+#define FAN_LENGTH 1000.0f
 
-	if (direction.x != 0.0)
+void GenerateRandomRects(RectBatch* rects, int count, float width, float height)
+{
+	for (int i = 0; i < count; i++)
 	{
-		float txMin = (rect.x - origin.x) / direction.x;
-		float txMax = ((rect.x + rect.width) - origin.x) / direction.x;
+		Rectangle rect = { 0 };
+		rect.width = (float)GetRandomValue(5, 40);
+		rect.height = (float)GetRandomValue(5, 40);
+		rect.x = (float)GetRandomValue(0, (int)(width - rect.width));
+		rect.y = (float)GetRandomValue(0, (int)(height - rect.height));
+		AddRectToBatch(rects, rect);
+	}
+}
 
-		minParam = fmaxf(minParam, fminf(txMin, txMax));
-		maxParam = fminf(maxParam, fmaxf(txMin, txMax));
+void BuildRayFan(RayBatch* rays, Vector2 origin, int count)
+{
+	rays->Count = 0;
+	for (int i = 0; i < count; i++)
+	{
+		float angle = (i * 360.0f / count) * DEG2RAD;
+		AddRayToBatch(rays, origin, (Vector2){ cosf(angle), sinf(angle) });
 	}
+}
 
-	if (direction.y != 0.0)
+// bvh scene
+// a mix of rectangles and circles in a bounding volume hierarchy, some of the circles move and the tree is refit every frame
+#define SCENE_SHAPES 1000
+#define SCENE_LENGTH 1000.0f
+
+void GenerateRandomShapes(BVHShape* shapes, int count, float width, float height)
+{
+	for (int i = 0; i < count; i++)
 	{
-		float tyMin = (rect.y - origin.y) / direction.y;
-		float tyMax = ((rect.y + rect.height) - origin.y) / direction.y;
+		if (GetRandomValue(0, 1) == 0)
+		{
+			float w = (float)GetRandomValue(2, 12);
+			float h = (float)GetRandomValue(2, 12);
+			shapes[i] = (BVHShape){ BVHShapeRect, (Rectangle){ (float)GetRandomValue(0, (int)(width - w)), (float)GetRandomValue(0, (int)(height - h)), w, h } };
+		}
+		else
+		{
+			float radius = (float)GetRandomValue(1, 6);
+			shapes[i] = (BVHShape){ BVHShapeCircle, (Rectangle){ 0 }, (Vector2){ (float)GetRandomValue((int)radius, (int)(width - radius)), (float)GetRandomValue((int)radius, (int)(height - radius)) }, radius };
+		}
+	}
+}
+
+void DrawBVHShape(const BVHShape* shape, Color color)
+{
+	if (shape->Type == BVHShapeCircle)
+		DrawCircleV(shape->Center, shape->Radius, color);
+	else
+		DrawRectangleRec(shape->Rect, color);
+}
 
-		minParam = fmaxf(minParam, fminf(tyMin, tyMax));
-		maxParam = fminf(maxParam, fmaxf(tyMin, tyMax));
+// ray benchmark
+// run with --ray-benchmark to compare casting rays one rectangle at a time against each batched kernel, without opening a window
+#define BENCHMARK_RAYS 10000
+#define BENCHMARK_RECTS 1000
+#define BENCHMARK_SIZE 4000
+#define BENCHMARK_REPEATS 5
+
+double GetBenchmarkTime()
+{
+	struct timespec now;
+	timespec_get(&now, TIME_UTC);
+	return (double)now.tv_sec + (double)now.tv_nsec / 1000000000.0;
+}
+
+void RunRayBenchmark()
+{
+	RayBatch rays;
+	RectBatch rects;
+	RayHits hits, scalarHits;
+	if (!InitRayBatch(&rays, BENCHMARK_RAYS) || !InitRectBatch(&rects, BENCHMARK_RECTS) || !InitRayHits(&hits, BENCHMARK_RAYS) || !InitRayHits(&scalarHits, BENCHMARK_RAYS))
+	{
+		printf("out of memory\n");
+		return;
 	}
 
-	// if maxParam < 0, ray is intersecting AABB, but the whole AABB is behind us
-	if (maxParam < 0)
+	SetRandomSeed(1234);
+	GenerateRandomRects(&rects, BENCHMARK_RECTS, BENCHMARK_SIZE, BENCHMARK_SIZE);
+
+	Rectangle* rectList = (Rectangle*)malloc(sizeof(Rectangle) * BENCHMARK_RECTS);
+	for (int i = 0; i < BENCHMARK_RECTS; i++)
+		rectList[i] = (Rectangle){ rects.MinX[i], rects.MinY[i], rects.MaxX[i] - rects.MinX[i], rects.MaxY[i] - rects.MinY[i] };
+
+	Vector2* origins = (Vector2*)malloc(sizeof(Vector2) * BENCHMARK_RAYS);
+	Vector2* directions = (Vector2*)malloc(sizeof(Vector2) * BENCHMARK_RAYS);
+	for (int i = 0; i < BENCHMARK_RAYS; i++)
 	{
-		return false;
+		origins[i] = (Vector2){ (float)GetRandomValue(0, BENCHMARK_SIZE), (float)GetRandomValue(0, BENCHMARK_SIZE) };
+		float angle = GetRandomValue(0, 3599) * 0.1f * DEG2RAD;
+		directions[i] = (Vector2){ cosf(angle), sinf(angle) };
+		AddRayToBatch(&rays, origins[i], directions[i]);
 	}
 
-	// if minParam > maxParam, ray doesn't intersect AABB
-	if (minParam > maxParam)
+	double tests = (double)BENCHMARK_RAYS * BENCHMARK_RECTS * BENCHMARK_REPEATS;
+
+	// one ray against one rectangle at a time, keeping the closest hit
+	int singleHits = 0;
+	double singleStart = GetBenchmarkTime();
+	for (int repeat = 0; repeat < BENCHMARK_REPEATS; repeat++)
 	{
-		return false;
+		singleHits = 0;
+		for (int ray = 0; ray < BENCHMARK_RAYS; ray++)
+		{
+			float nearest = INFINITY;
+			for (int i = 0; i < BENCHMARK_RECTS; i++)
+			{
+				Vector2 point = { 0, 0 };
+				if (RayIntersectRect(rectList[i], origins[ray], directions[ray], &point))
+					nearest = fminf(nearest, Vector2Distance(origins[ray], point));
+			}
+			if (nearest != INFINITY)
+				singleHits++;
+		}
 	}
+	double singleTime = GetBenchmarkTime() - singleStart;
+	printf("%d rays against %d rects\n", BENCHMARK_RAYS, BENCHMARK_RECTS);
+	printf("    one at a time %8.2f ns per test, %d rays hit\n", singleTime / tests * 1000000000.0, singleHits);
+
+	CastRayBatch(&rays, &rects, INFINITY, &scalarHits, RayScalar);
 
-	if (point != NULL)
+	for (int kernel = 0; kernel < RayKernelCount; kernel++)
 	{
-		*point = Vector2Add(origin, Vector2Scale(direction, minParam));
+		if (!RayKernelSupported((RayKernel)kernel))
+		{
+			printf("    %-13s not supported on this CPU\n", RayKernelNames[kernel]);
+			continue;
+		}
+
+		double start = GetBenchmarkTime();
+		for (int repeat = 0; repeat < BENCHMARK_REPEATS; repeat++)
+			CastRayBatch(&rays, &rects, INFINITY, &hits, (RayKernel)kernel);
+		double time = GetBenchmarkTime() - start;
+
+		// every kernel does the same math, so the results should match the scalar kernel exactly
+		int batchHits = 0;
+		int mismatches = 0;
+		for (int ray = 0; ray < BENCHMARK_RAYS; ray++)
+		{
+			if (hits.Rect[ray] >= 0)
+				batchHits++;
+			if (hits.Rect[ray] != scalarHits.Rect[ray] || hits.Distance[ray] != scalarHits.Distance[ray])
+				mismatches++;
+		}
+
+		printf("    %-13s %8.2f ns per test, %d rays hit, %d mismatches, %.1fx faster\n", RayKernelNames[kernel], time / tests * 1000000000.0, batchHits, mismatches, singleTime / time);
 	}
-	return true;
+
+	free(rectList);
+	free(origins);
+	free(directions);
+	FreeRayHits(&hits);
+	FreeRayHits(&scalarHits);
+	FreeRayBatch(&rays);
+	FreeRectBatch(&rects);
 }
 
-typedef struct
-{
-	Vector2 Origin;
-	Vector2 Direction;
-}Ray2d;
+// bvh benchmark
+// run with --bvh-benchmark to compare testing every shape against walking the tree, without opening a window
+#define BVH_BENCHMARK_RAYS 10000
+#define BVH_BENCHMARK_BRUTE_FORCE_TESTS 100000000 // brute force only casts as many rays as fit in this many shape tests
+#define BVH_BENCHMARK_DENSITY 0.05f // shapes per square pixel
+
+const int BVHBenchmarkSizes[] = { 1000, 10000, 100000 };
 
-bool CheckCollisionRay2dCircle(Ray2d ray, Vector2 center, float radius, Vector2* intersection)
+void RunBVHBenchmark()
 {
-	if (CheckCollisionPointCircle(ray.Origin, center, radius))
+	for (int size = 0; size < sizeof(BVHBenchmarkSizes) / sizeof(BVHBenchmarkSizes[0]); size++)
 	{
-		if (intersection)
-			*intersection = ray.Origin;
-
-		return true;
-	}
+		int count = BVHBenchmarkSizes[size];
+		float area = sqrtf(count / BVH_BENCHMARK_DENSITY) * 10;
 
-	Vector2 vecToCenter = Vector2Subtract(center, ray.Origin);
-	float dot = Vector2DotProduct(vecToCenter, ray.Direction);
+		BVHShape* shapes = (BVHShape*)malloc(sizeof(BVHShape) * count);
+		Vector2* origins = (Vector2*)malloc(sizeof(Vector2) * BVH_BENCHMARK_RAYS);
+		Vector2* directions = (Vector2*)malloc(sizeof(Vector2) * BVH_BENCHMARK_RAYS);
+		BVHHit* hits = (BVHHit*)malloc(sizeof(BVHHit) * BVH_BENCHMARK_RAYS);
 
-	if (dot < 0)
-		return false;
+		SetRandomSeed(1234);
+		GenerateRandomShapes(shapes, count, area, area);
+		for (int i = 0; i < BVH_BENCHMARK_RAYS; i++)
+		{
+			origins[i] = (Vector2){ (float)GetRandomValue(0, (int)area), (float)GetRandomValue(0, (int)area) };
+			float angle = GetRandomValue(0, 3599) * 0.1f * DEG2RAD;
+			directions[i] = (Vector2){ cosf(angle), sinf(angle) };
+		}
 
-	Vector2 nearest = Vector2Add(ray.Origin, Vector2Scale(ray.Direction, dot));
+		double buildStart = GetBenchmarkTime();
+		BVH bvh;
+		BuildBVH(&bvh, shapes, count);
+		double buildTime = GetBenchmarkTime() - buildStart;
 
-	Vector2 nearestToCenter = Vector2Subtract(center, nearest);
-	float distSq = Vector2LengthSqr(nearestToCenter);
+		// nearest hit with the tree
+		int bvhHits = 0;
+		double bvhStart = GetBenchmarkTime();
+		for (int ray = 0; ray < BVH_BENCHMARK_RAYS; ray++)
+		{
+			hits[ray].Shape = -1;
+			if (RaycastBVH(&bvh, origins[ray], directions[ray], INFINITY, &hits[ray]))
+				bvhHits++;
+		}
+		double bvhTime = GetBenchmarkTime() - bvhStart;
 
-	if (distSq <= radius * radius)
-	{
-		if (intersection)
+		int anyHits = 0;
+		double anyStart = GetBenchmarkTime();
+		for (int ray = 0; ray < BVH_BENCHMARK_RAYS; ray++)
 		{
-			float nearestDist = Vector2Length(Vector2Subtract(center, nearest));
+			if (RayHitsAnyBVH(&bvh, origins[ray], directions[ray], INFINITY))
+				anyHits++;
+		}
+		double anyTime = GetBenchmarkTime() - anyStart;
 
-			float b = sqrtf(radius * radius - nearestDist * nearestDist);
+		// nearest hit testing every shape, checked against the tree
+		int bruteRays = BVH_BENCHMARK_BRUTE_FORCE_TESTS / count;
+		if (bruteRays > BVH_BENCHMARK_RAYS)
+			bruteRays = BVH_BENCHMARK_RAYS;
 
-			*intersection = (Vector2){ ray.Origin.x + ray.Direction.x * (dot - b), ray.Origin.y + ray.Direction.y * (dot - b) };
+		int bruteHits = 0;
+		int mismatches = 0;
+		double bruteStart = GetBenchmarkTime();
+		for (int ray = 0; ray < bruteRays; ray++)
+		{
+			float nearest = INFINITY;
+			int nearestShape = -1;
+			for (int i = 0; i < count; i++)
+			{
+				float distance = 0;
+				if (RayIntersectBVHShape(&shapes[i], origins[ray], directions[ray], &distance) && (distance < nearest || nearestShape < 0))
+				{
+					nearest = distance;
+					nearestShape = i;
+				}
+			}
+
+			if (nearestShape >= 0)
+				bruteHits++;
+			if (nearestShape != hits[ray].Shape)
+				mismatches++;
 		}
+		double bruteTime = GetBenchmarkTime() - bruteStart;
 
-		return true;
-	}
+		// move every shape a little and refit the tree to them
+		for (int i = 0; i < count; i++)
+		{
+			Vector2 move = { (float)GetRandomValue(-5, 5), (float)GetRandomValue(-5, 5) };
+			shapes[i].Rect.x += move.x;
+			shapes[i].Rect.y += move.y;
+			shapes[i].Center = Vector2Add(shapes[i].Center, move);
+		}
 
-	return false;
-}
+		double refitStart = GetBenchmarkTime();
+		RefitBVH(&bvh);
+		double refitTime = GetBenchmarkTime() - refitStart;
+
+		double bruteRayTime = bruteTime / bruteRays;
+		double bvhRayTime = bvhTime / BVH_BENCHMARK_RAYS;
 
+		printf("%6d shapes, %d nodes built in %.2f ms, refit in %.2f ms\n", count, bvh.NodeCount, buildTime * 1000.0, refitTime * 1000.0);
+		printf("    brute force %9.3f us per ray, %d hits in %d rays\n", bruteRayTime * 1000000.0, bruteHits, bruteRays);
+		printf("    bvh nearest %9.3f us per ray, %d hits in %d rays, %.0fx faster, %d mismatches\n", bvhRayTime * 1000000.0, bvhHits, BVH_BENCHMARK_RAYS, bruteRayTime / bvhRayTime, mismatches);
+		printf("    bvh any     %9.3f us per ray, %d hits in %d rays\n", anyTime / BVH_BENCHMARK_RAYS * 1000000.0, anyHits, BVH_BENCHMARK_RAYS);
+
+		FreeBVH(&bvh);
+		free(shapes);
+		free(origins);
+		free(directions);
+		free(hits);
+	}
+}
 
-int main(void)
+int main(int argc, char* argv[])
 {
+	if (argc > 1 && strcmp(argv[1], "--ray-benchmark") == 0)
+	{
+		RunRayBenchmark();
+		return 0;
+	}
+
+	if (argc > 1 && strcmp(argv[1], "--bvh-benchmark") == 0)
+	{
+		RunBVHBenchmark();
+		return 0;
+	}
+
 	const int screenWidth = 800;
 	const int screenHeight = 450;
 
@@ -125,6 +333,28 @@ int main(void)
 	Vector2 center = { 600, 200 };
 	float radius = 50;
 
+	// press F to cast a fan of rays from the mouse against a field of rectangles
+	bool showFan = false;
+	RayBatch fanRays;
+	RectBatch fanRects;
+	RayHits fanHits;
+	InitRayBatch(&fanRays, FAN_RAYS);
+	InitRectBatch(&fanRects, FAN_RECTS);
+	InitRayHits(&fanHits, FAN_RAYS);
+	GenerateRandomRects(&fanRects, FAN_RECTS, (float)screenWidth, (float)screenHeight);
+	RayKernel fanKernel = GetBestRayKernel();
+
+	// press V for a scene of shapes in a bvh, a ray from the mouse finds the nearest one and a line to the yellow origin checks if anything blocks it
+	bool showScene = false;
+	BVHShape* sceneShapes = (BVHShape*)malloc(sizeof(BVHShape) * SCENE_SHAPES);
+	GenerateRandomShapes(sceneShapes, SCENE_SHAPES, (float)screenWidth, (float)screenHeight);
+	Vector2* sceneHomes = (Vector2*)malloc(sizeof(Vector2) * SCENE_SHAPES);
+	for (int i = 0; i < SCENE_SHAPES; i++)
+		sceneHomes[i] = sceneShapes[i].Center;
+
+	BVH sceneBVH;
+	BuildBVH(&sceneBVH, sceneShapes, SCENE_SHAPES);
+
 	// Main game loop
 	while (!WindowShouldClose())    // Detect window close button or ESC key
 	{
@@ -134,6 +364,11 @@ int main(void)
 		if (IsKeyDown(KEY_RIGHT))
 			angleDelta += GetFrameTime() * 90;
 
+		if (IsKeyPressed(KEY_F))
+			showFan = !showFan;
+		if (IsKeyPressed(KEY_V))
+			showScene = !showScene;
+
 		Vector2 intersect = (Vector2){ 0, 0 };
 		Matrix rotMat = MatrixRotateZ(angleDelta * DEG2RAD);
 		direction = Vector2Transform(direction, rotMat);
@@ -141,6 +376,64 @@ int main(void)
 		BeginDrawing();
 		ClearBackground(BLACK);
 
+		if (showFan)
+		{
+			Vector2 mouse = GetMousePosition();
+			BuildRayFan(&fanRays, mouse, FAN_RAYS);
+			CastRayBatch(&fanRays, &fanRects, FAN_LENGTH, &fanHits, fanKernel);
+
+			for (int i = 0; i < fanRects.Count; i++)
+				DrawRectangleRec((Rectangle) { fanRects.MinX[i], fanRects.MinY[i], fanRects.MaxX[i] - fanRects.MinX[i], fanRects.MaxY[i] - fanRects.MinY[i] }, DARKGRAY);
+
+			for (int i = 0; i < fanRays.Count; i++)
+			{
+				float angle = (i * 360.0f / FAN_RAYS) * DEG2RAD;
+				Vector2 end = Vector2Add(mouse, Vector2Scale((Vector2) { cosf(angle), sinf(angle) }, fanHits.Distance[i]));
+				DrawLineV(mouse, end, Fade(YELLOW, 0.25f));
+			}
+
+			DrawText(TextFormat("%d rays against %d rects using %s", FAN_RAYS, FAN_RECTS, RayKernelNames[fanKernel]), 10, 10, 20, WHITE);
+			EndDrawing();
+			continue;
+		}
+
+		if (showScene)
+		{
+			// the circles bob around where they started, small moves like this only need a refit
+			for (int i = 0; i < SCENE_SHAPES; i++)
+			{
+				if (sceneShapes[i].Type == BVHShapeCircle)
+					sceneShapes[i].Center.y = sceneHomes[i].y + sinf((float)GetTime() * 2 + i) * 10;
+			}
+			RefitBVH(&sceneBVH);
+
+			for (int i = 0; i < SCENE_SHAPES; i++)
+				DrawBVHShape(&sceneShapes[i], DARKGRAY);
+
+			Vector2 mouse = GetMousePosition();
+			BVHHit sceneHit = { 0 };
+			if (RaycastBVH(&sceneBVH, mouse, direction, SCENE_LENGTH, &sceneHit))
+			{
+				DrawBVHShape(&sceneShapes[sceneHit.Shape], RED);
+				DrawLineV(mouse, sceneHit.Point, BLUE);
+				DrawCircleV(sceneHit.Point, 4, GREEN);
+			}
+			else
+			{
+				DrawLineV(mouse, Vector2Add(mouse, Vector2Scale(direction, SCENE_LENGTH)), BLUE);
+			}
+
+			Vector2 toOrigin = Vector2Subtract(origin, mouse);
+			float originDistance = Vector2Length(toOrigin);
+			bool blocked = originDistance > 0 && RayHitsAnyBVH(&sceneBVH, mouse, Vector2Scale(toOrigin, 1.0f / originDistance), originDistance);
+			DrawLineV(mouse, origin, blocked ? Fade(RED, 0.5f) : Fade(GREEN, 0.5f));
+			DrawCircleV(origin, 10, YELLOW);
+
+			DrawText(TextFormat("%d shapes in %d bvh nodes, arrows rotate the ray", SCENE_SHAPES, sceneBVH.NodeCount), 10, 10, 20, WHITE);
+			EndDrawing();
+			continue;
+		}
+
 		bool hit = RayIntersectRect(rect, origin, direction, &intersect);
 
 		DrawRectangleRec(rect, hit ? RED : GRAY);
@@ -166,8 +459,19 @@ int main(void)
 
 		DrawLineV(origin, Vector2Add(origin, Vector2Scale(direction, 500)), BLUE);
 
+		DrawText("Press F to cast a fan of rays, V for a bvh scene", 10, 10, 20, WHITE);
+
 		EndDrawing();
 	}
+
+	FreeBVH(&sceneBVH);
+	free(sceneShapes);
+	free(sceneHomes);
+
+	FreeRayHits(&fanHits);
+	FreeRectBatch(&fanRects);
+	FreeRayBatch(&fanRays);
+
 	CloseWindow();
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,360 @@
+#include "ray_batch.h"
+
+#include <stdlib.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RAY_BATCH_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// gcc and clang need to be told a function may use AVX2, msvc allows the intrinsics anywhere
+#if defined(RAY_BATCH_X86) && (defined(__GNUC__) || defined(__clang__))
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#else
+#define AVX2_FUNCTION
+#endif
+
+const char* RayKernelNames[RayKernelCount] = { "Scalar", "SSE", "AVX2" };
+
+bool InitRayBatch(RayBatch* rays, int capacity)
+{
+    rays->Count = 0;
+    rays->Capacity = capacity;
+    rays->OriginX = (float*)malloc(sizeof(float) * capacity);
+    rays->OriginY = (float*)malloc(sizeof(float) * capacity);
+    rays->InverseDirectionX = (float*)malloc(sizeof(float) * capacity);
+    rays->InverseDirectionY = (float*)malloc(sizeof(float) * capacity);
+
+    if (!rays->OriginX || !rays->OriginY || !rays->InverseDirectionX || !rays->InverseDirectionY)
+    {
+        FreeRayBatch(rays);
+        return false;
+    }
+    return true;
+}
+
+void FreeRayBatch(RayBatch* rays)
+{
+    free(rays->OriginX);
+    free(rays->OriginY);
+    free(rays->InverseDirectionX);
+    free(rays->InverseDirectionY);
+
+    rays->OriginX = rays->OriginY = rays->InverseDirectionX = rays->InverseDirectionY = NULL;
+    rays->Count = 0;
+    rays->Capacity = 0;
+}
+
+void AddRayToBatch(RayBatch* rays, Vector2 origin, Vector2 direction)
+{
+    if (rays->Count >= rays->Capacity)
+        return;
+
+    int i = rays->Count++;
+    rays->OriginX[i] = origin.x;
+    rays->OriginY[i] = origin.y;
+
+    // dividing by 0 gives infinity, which is what the slab test wants
+    rays->InverseDirectionX[i] = 1.0f / direction.x;
+    rays->InverseDirectionY[i] = 1.0f / direction.y;
+}
+
+bool InitRectBatch(RectBatch* rects, int capacity)
+{
+    rects->Count = 0;
+    rects->Capacity = capacity;
+    rects->MinX = (float*)malloc(sizeof(float) * capacity);
+    rects->MinY = (float*)malloc(sizeof(float) * capacity);
+    rects->MaxX = (float*)malloc(sizeof(float) * capacity);
+    rects->MaxY = (float*)malloc(sizeof(float) * capacity);
+
+    if (!rects->MinX || !rects->MinY || !rects->MaxX || !rects->MaxY)
+    {
+        FreeRectBatch(rects);
+        return false;
+    }
+    return true;
+}
+
+void FreeRectBatch(RectBatch* rects)
+{
+    free(rects->MinX);
+    free(rects->MinY);
+    free(rects->MaxX);
+    free(rects->MaxY);
+
+    rects->MinX = rects->MinY = rects->MaxX = rects->MaxY = NULL;
+    rects->Count = 0;
+    rects->Capacity = 0;
+}
+
+void AddRectToBatch(RectBatch* rects, Rectangle rect)
+{
+    if (rects->Count >= rects->Capacity)
+        return;
+
+    int i = rects->Count++;
+    rects->MinX[i] = rect.x;
+    rects->MinY[i] = rect.y;
+    rects->MaxX[i] = rect.x + rect.width;
+    rects->MaxY[i] = rect.y + rect.height;
+}
+
+bool InitRayHits(RayHits* hits, int count)
+{
+    hits->Rect = (int*)malloc(sizeof(int) * count);
+    hits->Distance = (float*)malloc(sizeof(float) * count);
+
+    if (!hits->Rect || !hits->Distance)
+    {
+        FreeRayHits(hits);
+        return false;
+    }
+    return true;
+}
+
+void FreeRayHits(RayHits* hits)
+{
+    free(hits->Rect);
+    free(hits->Distance);
+
+    hits->Rect = NULL;
+    hits->Distance = NULL;
+}
+
+bool RayKernelSupported(RayKernel kernel)
+{
+    switch (kernel)
+    {
+    case RayScalar:
+        return true;
+
+#if defined(RAY_BATCH_X86)
+    case RaySSE:
+        return true; // every x64 CPU has SSE2
+
+    case RayAVX2:
+#if defined(_MSC_VER)
+    {
+        // the CPU has to support AVX2, and the OS has to save the AVX registers
+        int info[4];
+        __cpuid(info, 1);
+        bool osSavesAVX = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        return osSavesAVX && (info[1] & (1 << 5));
+    }
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+#endif
+
+    default:
+        return false;
+    }
+}
+
+RayKernel GetBestRayKernel()
+{
+    for (int kernel = RayKernelCount - 1; kernel > RayScalar; kernel--)
+    {
+        if (RayKernelSupported((RayKernel)kernel))
+            return (RayKernel)kernel;
+    }
+    return RayScalar;
+}
+
+// the same as minps and maxps, which return the second value when either is NaN
+// a ray that starts exactly on the edge of a slab multiplies 0 by infinity, so this keeps every kernel giving the same answer
+static float MinFloat(float a, float b) { return a < b ? a : b; }
+static float MaxFloat(float a, float b) { return a > b ? a : b; }
+
+// tests one ray against rects from first on, updating the nearest hit so far
+static void CastRayScalar(const RayBatch* rays, int ray, const RectBatch* rects, int first, float* nearest, int* nearestRect)
+{
+    float originX = rays->OriginX[ray];
+    float originY = rays->OriginY[ray];
+    float inverseX = rays->InverseDirectionX[ray];
+    float inverseY = rays->InverseDirectionY[ray];
+
+    for (int i = first; i < rects->Count; i++)
+    {
+        float tx1 = (rects->MinX[i] - originX) * inverseX;
+        float tx2 = (rects->MaxX[i] - originX) * inverseX;
+        float ty1 = (rects->MinY[i] - originY) * inverseY;
+        float ty2 = (rects->MaxY[i] - originY) * inverseY;
+
+        float enter = MaxFloat(MinFloat(tx1, tx2), MinFloat(ty1, ty2));
+        float exit = MinFloat(MaxFloat(tx1, tx2), MaxFloat(ty1, ty2));
+
+        // a ray that starts inside hits at 0
+        enter = MaxFloat(enter, 0.0f);
+
+        if (enter <= exit && enter < *nearest)
+        {
+            *nearest = enter;
+            *nearestRect = i;
+        }
+    }
+}
+
+static void CastRayBatchScalar(const RayBatch* rays, const RectBatch* rects, float maxDistance, RayHits* hits)
+{
+    for (int ray = 0; ray < rays->Count; ray++)
+    {
+        float nearest = maxDistance;
+        int nearestRect = -1;
+        CastRayScalar(rays, ray, rects, 0, &nearest, &nearestRect);
+
+        hits->Distance[ray] = nearest;
+        hits->Rect[ray] = nearestRect;
+    }
+}
+
+#if defined(RAY_BATCH_X86)
+static void CastRayBatchSSE(const RayBatch* rays, const RectBatch* rects, float maxDistance, RayHits* hits)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128i four = _mm_set1_epi32(4);
+
+    for (int ray = 0; ray < rays->Count; ray++)
+    {
+        __m128 originX = _mm_set1_ps(rays->OriginX[ray]);
+        __m128 originY = _mm_set1_ps(rays->OriginY[ray]);
+        __m128 inverseX = _mm_set1_ps(rays->InverseDirectionX[ray]);
+        __m128 inverseY = _mm_set1_ps(rays->InverseDirectionY[ray]);
+
+        // each lane keeps the nearest hit among the rectangles it has seen
+        __m128 nearest = _mm_set1_ps(maxDistance);
+        __m128i nearestRect = _mm_set1_epi32(-1);
+        __m128i rectIndex = _mm_setr_epi32(0, 1, 2, 3);
+
+        int i = 0;
+        for (; i + 4 <= rects->Count; i += 4)
+        {
+            __m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(rects->MinX + i), originX), inverseX);
+            __m128 tx2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(rects->MaxX + i), originX), inverseX);
+            __m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(rects->MinY + i), originY), inverseY);
+            __m128 ty2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(rects->MaxY + i), originY), inverseY);
+
+            __m128 enter = _mm_max_ps(_mm_min_ps(tx1, tx2), _mm_min_ps(ty1, ty2));
+            __m128 exit = _mm_min_ps(_mm_max_ps(tx1, tx2), _mm_max_ps(ty1, ty2));
+            enter = _mm_max_ps(enter, zero);
+
+            __m128 closer = _mm_and_ps(_mm_cmple_ps(enter, exit), _mm_cmplt_ps(enter, nearest));
+            nearest = _mm_or_ps(_mm_and_ps(closer, enter), _mm_andnot_ps(closer, nearest));
+            nearestRect = _mm_or_si128(_mm_and_si128(_mm_castps_si128(closer), rectIndex), _mm_andnot_si128(_mm_castps_si128(closer), nearestRect));
+
+            rectIndex = _mm_add_epi32(rectIndex, four);
+        }
+
+        // pick the nearest of the lanes, on a tie the lowest rectangle wins, the same as testing them in order
+        float laneNearest[4];
+        int laneRect[4];
+        _mm_storeu_ps(laneNearest, nearest);
+        _mm_storeu_si128((__m128i*)laneRect, nearestRect);
+
+        float best = maxDistance;
+        int bestRect = -1;
+        for (int lane = 0; lane < 4; lane++)
+        {
+            if (laneRect[lane] < 0)
+                continue;
+
+            if (laneNearest[lane] < best || (laneNearest[lane] == best && (bestRect < 0 || laneRect[lane] < bestRect)))
+            {
+                best = laneNearest[lane];
+                bestRect = laneRect[lane];
+            }
+        }
+
+        CastRayScalar(rays, ray, rects, i, &best, &bestRect);
+
+        hits->Distance[ray] = best;
+        hits->Rect[ray] = bestRect;
+    }
+}
+
+AVX2_FUNCTION static void CastRayBatchAVX2(const RayBatch* rays, const RectBatch* rects, float maxDistance, RayHits* hits)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256i eight = _mm256_set1_epi32(8);
+
+    for (int ray = 0; ray < rays->Count; ray++)
+    {
+        __m256 originX = _mm256_set1_ps(rays->OriginX[ray]);
+        __m256 originY = _mm256_set1_ps(rays->OriginY[ray]);
+        __m256 inverseX = _mm256_set1_ps(rays->InverseDirectionX[ray]);
+        __m256 inverseY = _mm256_set1_ps(rays->InverseDirectionY[ray]);
+
+        // each lane keeps the nearest hit among the rectangles it has seen
+        __m256 nearest = _mm256_set1_ps(maxDistance);
+        __m256i nearestRect = _mm256_set1_epi32(-1);
+        __m256i rectIndex = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+        int i = 0;
+        for (; i + 8 <= rects->Count; i += 8)
+        {
+            __m256 tx1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(rects->MinX + i), originX), inverseX);
+            __m256 tx2 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(rects->MaxX + i), originX), inverseX);
+            __m256 ty1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(rects->MinY + i), originY), inverseY);
+            __m256 ty2 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(rects->MaxY + i), originY), inverseY);
+
+            __m256 enter = _mm256_max_ps(_mm256_min_ps(tx1, tx2), _mm256_min_ps(ty1, ty2));
+            __m256 exit = _mm256_min_ps(_mm256_max_ps(tx1, tx2), _mm256_max_ps(ty1, ty2));
+            enter = _mm256_max_ps(enter, zero);
+
+            __m256 closer = _mm256_and_ps(_mm256_cmp_ps(enter, exit, _CMP_LE_OQ), _mm256_cmp_ps(enter, nearest, _CMP_LT_OQ));
+            nearest = _mm256_blendv_ps(nearest, enter, closer);
+            nearestRect = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(nearestRect), _mm256_castsi256_ps(rectIndex), closer));
+
+            rectIndex = _mm256_add_epi32(rectIndex, eight);
+        }
+
+        // pick the nearest of the lanes, on a tie the lowest rectangle wins, the same as testing them in order
+        float laneNearest[8];
+        int laneRect[8];
+        _mm256_storeu_ps(laneNearest, nearest);
+        _mm256_storeu_si256((__m256i*)laneRect, nearestRect);
+
+        float best = maxDistance;
+        int bestRect = -1;
+        for (int lane = 0; lane < 8; lane++)
+        {
+            if (laneRect[lane] < 0)
+                continue;
+
+            if (laneNearest[lane] < best || (laneNearest[lane] == best && (bestRect < 0 || laneRect[lane] < bestRect)))
+            {
+                best = laneNearest[lane];
+                bestRect = laneRect[lane];
+            }
+        }
+
+        CastRayScalar(rays, ray, rects, i, &best, &bestRect);
+
+        hits->Distance[ray] = best;
+        hits->Rect[ray] = bestRect;
+    }
+}
+#endif
+
+void CastRayBatch(const RayBatch* rays, const RectBatch* rects, float maxDistance, RayHits* hits, RayKernel kernel)
+{
+    switch (kernel)
+    {
+#if defined(RAY_BATCH_X86)
+    case RaySSE:
+        CastRayBatchSSE(rays, rects, maxDistance, hits);
+        break;
+    case RayAVX2:
+        CastRayBatchAVX2(rays, rects, maxDistance, hits);
+        break;
+#endif
+    default:
+        CastRayBatchScalar(rays, rects, maxDistance, hits);
+        break;
+    }
+}
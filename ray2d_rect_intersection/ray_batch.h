@@ -0,0 +1,67 @@
+#pragma once
+
+#include "raylib.h"
+
+#include <stdbool.h>
+
+// casts many rays against many rectangles, finding the nearest rectangle each ray hits
+// rays and rectangles are stored as structures of arrays, and each ray is tested against 4 or 8 rectangles at a time
+// each ray keeps 1 / direction, so the slab tests are all multiplies, and a direction of 0 becomes infinity which the test handles without a branch
+
+typedef struct RayBatch
+{
+    int Count;
+    int Capacity;
+
+    float* OriginX;
+    float* OriginY;
+    float* InverseDirectionX;
+    float* InverseDirectionY;
+}RayBatch;
+
+typedef struct RectBatch
+{
+    int Count;
+    int Capacity;
+
+    float* MinX;
+    float* MinY;
+    float* MaxX;
+    float* MaxY;
+}RectBatch;
+
+// the nearest hit for each ray, Rect is -1 if the ray didn't hit anything
+// Distance is in lengths of the ray's direction, so with a normalized direction it is in pixels
+typedef struct RayHits
+{
+    int* Rect;
+    float* Distance;
+}RayHits;
+
+typedef enum
+{
+    RayScalar = 0,
+    RaySSE,
+    RayAVX2,
+    RayKernelCount,
+}RayKernel;
+
+extern const char* RayKernelNames[RayKernelCount];
+
+bool InitRayBatch(RayBatch* rays, int capacity);
+void FreeRayBatch(RayBatch* rays);
+void AddRayToBatch(RayBatch* rays, Vector2 origin, Vector2 direction);
+
+bool InitRectBatch(RectBatch* rects, int capacity);
+void FreeRectBatch(RectBatch* rects);
+void AddRectToBatch(RectBatch* rects, Rectangle rect);
+
+bool InitRayHits(RayHits* hits, int count);
+void FreeRayHits(RayHits* hits);
+
+bool RayKernelSupported(RayKernel kernel);
+RayKernel GetBestRayKernel();
+
+// finds the nearest rectangle each ray hits within maxDistance
+// a ray that starts inside a rectangle hits it at a distance of 0
+void CastRayBatch(const RayBatch* rays, const RectBatch* rects, float maxDistance, RayHits* hits, RayKernel kernel);
@@ -0,0 +1,317 @@
+#include "nearest_rect.h"
+
+#include <stdlib.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define NEAREST_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// gcc and clang need to be told a function may use newer instructions, msvc allows the intrinsics anywhere
+#if defined(NEAREST_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SSE41_FUNCTION __attribute__((target("sse4.1")))
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#else
+#define SSE41_FUNCTION
+#define AVX2_FUNCTION
+#endif
+
+const char* NearestKernelNames[NearestKernelCount] = { "Scalar", "SSE4.1", "AVX2" };
+
+bool InitRectArrays(RectArrays* rects, int capacity)
+{
+    rects->Count = 0;
+    rects->Capacity = capacity;
+    rects->X = (float*)malloc(sizeof(float) * capacity);
+    rects->Y = (float*)malloc(sizeof(float) * capacity);
+    rects->Width = (float*)malloc(sizeof(float) * capacity);
+    rects->Height = (float*)malloc(sizeof(float) * capacity);
+
+    if (!rects->X || !rects->Y || !rects->Width || !rects->Height)
+    {
+        FreeRectArrays(rects);
+        return false;
+    }
+    return true;
+}
+
+void FreeRectArrays(RectArrays* rects)
+{
+    free(rects->X);
+    free(rects->Y);
+    free(rects->Width);
+    free(rects->Height);
+
+    rects->X = rects->Y = rects->Width = rects->Height = NULL;
+    rects->Count = 0;
+    rects->Capacity = 0;
+}
+
+void AddRectToArrays(RectArrays* rects, Rectangle rect)
+{
+    if (rects->Count >= rects->Capacity)
+        return;
+
+    int i = rects->Count++;
+    rects->X[i] = rect.x;
+    rects->Y[i] = rect.y;
+    rects->Width[i] = rect.width;
+    rects->Height[i] = rect.height;
+}
+
+bool InitNearestPoints(NearestPoints* points, int count)
+{
+    points->X = (float*)malloc(sizeof(float) * count);
+    points->Y = (float*)malloc(sizeof(float) * count);
+    points->NormalX = (float*)malloc(sizeof(float) * count);
+    points->NormalY = (float*)malloc(sizeof(float) * count);
+    points->DistanceSqr = (float*)malloc(sizeof(float) * count);
+
+    if (!points->X || !points->Y || !points->NormalX || !points->NormalY || !points->DistanceSqr)
+    {
+        FreeNearestPoints(points);
+        return false;
+    }
+    return true;
+}
+
+void FreeNearestPoints(NearestPoints* points)
+{
+    free(points->X);
+    free(points->Y);
+    free(points->NormalX);
+    free(points->NormalY);
+    free(points->DistanceSqr);
+
+    points->X = points->Y = points->NormalX = points->NormalY = points->DistanceSqr = NULL;
+}
+
+bool NearestKernelSupported(NearestKernel kernel)
+{
+    switch (kernel)
+    {
+    case NearestScalar:
+        return true;
+
+#if defined(NEAREST_X86)
+#if defined(_MSC_VER)
+    case NearestSSE41:
+    {
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 19)) != 0;
+    }
+    case NearestAVX2:
+    {
+        // the CPU has to support AVX2, and the OS has to save the AVX registers
+        int info[4];
+        __cpuid(info, 1);
+        bool osSavesAVX = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        return osSavesAVX && (info[1] & (1 << 5));
+    }
+#else
+    case NearestSSE41:
+        return __builtin_cpu_supports("sse4.1");
+    case NearestAVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+#endif
+
+    default:
+        return false;
+    }
+}
+
+NearestKernel GetBestNearestKernel()
+{
+    for (int kernel = NearestKernelCount - 1; kernel > NearestScalar; kernel--)
+    {
+        if (NearestKernelSupported((NearestKernel)kernel))
+            return (NearestKernel)kernel;
+    }
+    return NearestScalar;
+}
+
+// PointNearestRectanglePoint works out a point on the nearest vertical side and a point on the nearest horizontal side, and keeps the closer one
+// a point on a side is the start of the side plus how far along it the point is, clamped to the side, and every kernel keeps those exact steps
+// the distance along a side is a dot product with an axis, it is done as the same multiplies and adds, so the sign of a zero is the same too
+// selects are used instead of clamping with min and max, since a clamp would add 0 to the start of a side, which changes an edge at -0
+
+static void NearestRectanglePointsScalar(const RectArrays* rects, Vector2 point, NearestPoints* results, int first)
+{
+    for (int i = first; i < rects->Count; i++)
+    {
+        float left = rects->X[i];
+        float top = rects->Y[i];
+        float right = left + rects->Width[i];
+        float bottom = top + rects->Height[i];
+
+        // the nearest vertical side
+        bool pastRight = point.x > right;
+        float hValue = pastRight ? right : left;
+        float hNormal = pastRight ? 1.0f : -1.0f;
+
+        float alongV = 0.0f * (hValue - point.x) + -(top - point.y);
+        float hY = alongV < 0 ? top : (alongV >= rects->Height[i] ? bottom : top + alongV);
+
+        // the nearest horizontal side
+        bool pastBottom = point.y > bottom;
+        float vValue = pastBottom ? bottom : top;
+        float vNormal = pastBottom ? 1.0f : -1.0f;
+
+        float alongH = -(left - point.x) + 0.0f * (vValue - point.y);
+        float vX = alongH < 0 ? left : (alongH >= rects->Width[i] ? right : left + alongH);
+
+        float hDX = point.x - hValue;
+        float hDY = point.y - hY;
+        float hDistance = hDX * hDX + hDY * hDY;
+
+        float vDX = point.x - vX;
+        float vDY = point.y - vValue;
+        float vDistance = vDX * vDX + vDY * vDY;
+
+        bool useH = hDistance < vDistance;
+        results->X[i] = useH ? hValue : vX;
+        results->Y[i] = useH ? hY : vValue;
+        results->NormalX[i] = useH ? hNormal : 0.0f;
+        results->NormalY[i] = useH ? 0.0f : vNormal;
+        results->DistanceSqr[i] = useH ? hDistance : vDistance;
+    }
+}
+
+#if defined(NEAREST_X86)
+SSE41_FUNCTION static void NearestRectanglePointsSSE41(const RectArrays* rects, Vector2 point, NearestPoints* results)
+{
+    const __m128 pointX = _mm_set1_ps(point.x);
+    const __m128 pointY = _mm_set1_ps(point.y);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minusOne = _mm_set1_ps(-1.0f);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+
+    int i = 0;
+    for (; i + 4 <= rects->Count; i += 4)
+    {
+        __m128 left = _mm_loadu_ps(rects->X + i);
+        __m128 top = _mm_loadu_ps(rects->Y + i);
+        __m128 width = _mm_loadu_ps(rects->Width + i);
+        __m128 height = _mm_loadu_ps(rects->Height + i);
+        __m128 right = _mm_add_ps(left, width);
+        __m128 bottom = _mm_add_ps(top, height);
+
+        // the nearest vertical side
+        __m128 pastRight = _mm_cmpgt_ps(pointX, right);
+        __m128 hValue = _mm_blendv_ps(left, right, pastRight);
+        __m128 hNormal = _mm_blendv_ps(minusOne, one, pastRight);
+
+        __m128 alongV = _mm_add_ps(_mm_mul_ps(zero, _mm_sub_ps(hValue, pointX)), _mm_xor_ps(_mm_sub_ps(top, pointY), signBit));
+        __m128 hY = _mm_blendv_ps(_mm_add_ps(top, alongV), bottom, _mm_cmpge_ps(alongV, height));
+        hY = _mm_blendv_ps(hY, top, _mm_cmplt_ps(alongV, zero));
+
+        // the nearest horizontal side
+        __m128 pastBottom = _mm_cmpgt_ps(pointY, bottom);
+        __m128 vValue = _mm_blendv_ps(top, bottom, pastBottom);
+        __m128 vNormal = _mm_blendv_ps(minusOne, one, pastBottom);
+
+        __m128 alongH = _mm_add_ps(_mm_xor_ps(_mm_sub_ps(left, pointX), signBit), _mm_mul_ps(zero, _mm_sub_ps(vValue, pointY)));
+        __m128 vX = _mm_blendv_ps(_mm_add_ps(left, alongH), right, _mm_cmpge_ps(alongH, width));
+        vX = _mm_blendv_ps(vX, left, _mm_cmplt_ps(alongH, zero));
+
+        __m128 hDX = _mm_sub_ps(pointX, hValue);
+        __m128 hDY = _mm_sub_ps(pointY, hY);
+        __m128 hDistance = _mm_add_ps(_mm_mul_ps(hDX, hDX), _mm_mul_ps(hDY, hDY));
+
+        __m128 vDX = _mm_sub_ps(pointX, vX);
+        __m128 vDY = _mm_sub_ps(pointY, vValue);
+        __m128 vDistance = _mm_add_ps(_mm_mul_ps(vDX, vDX), _mm_mul_ps(vDY, vDY));
+
+        __m128 useH = _mm_cmplt_ps(hDistance, vDistance);
+        _mm_storeu_ps(results->X + i, _mm_blendv_ps(vX, hValue, useH));
+        _mm_storeu_ps(results->Y + i, _mm_blendv_ps(vValue, hY, useH));
+        _mm_storeu_ps(results->NormalX + i, _mm_and_ps(hNormal, useH));
+        _mm_storeu_ps(results->NormalY + i, _mm_andnot_ps(useH, vNormal));
+        _mm_storeu_ps(results->DistanceSqr + i, _mm_blendv_ps(vDistance, hDistance, useH));
+    }
+
+    NearestRectanglePointsScalar(rects, point, results, i);
+}
+
+AVX2_FUNCTION static void NearestRectanglePointsAVX2(const RectArrays* rects, Vector2 point, NearestPoints* results)
+{
+    const __m256 pointX = _mm256_set1_ps(point.x);
+    const __m256 pointY = _mm256_set1_ps(point.y);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 minusOne = _mm256_set1_ps(-1.0f);
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+
+    int i = 0;
+    for (; i + 8 <= rects->Count; i += 8)
+    {
+        __m256 left = _mm256_loadu_ps(rects->X + i);
+        __m256 top = _mm256_loadu_ps(rects->Y + i);
+        __m256 width = _mm256_loadu_ps(rects->Width + i);
+        __m256 height = _mm256_loadu_ps(rects->Height + i);
+        __m256 right = _mm256_add_ps(left, width);
+        __m256 bottom = _mm256_add_ps(top, height);
+
+        // the nearest vertical side
+        __m256 pastRight = _mm256_cmp_ps(pointX, right, _CMP_GT_OQ);
+        __m256 hValue = _mm256_blendv_ps(left, right, pastRight);
+        __m256 hNormal = _mm256_blendv_ps(minusOne, one, pastRight);
+
+        __m256 alongV = _mm256_add_ps(_mm256_mul_ps(zero, _mm256_sub_ps(hValue, pointX)), _mm256_xor_ps(_mm256_sub_ps(top, pointY), signBit));
+        __m256 hY = _mm256_blendv_ps(_mm256_add_ps(top, alongV), bottom, _mm256_cmp_ps(alongV, height, _CMP_GE_OQ));
+        hY = _mm256_blendv_ps(hY, top, _mm256_cmp_ps(alongV, zero, _CMP_LT_OQ));
+
+        // the nearest horizontal side
+        __m256 pastBottom = _mm256_cmp_ps(pointY, bottom, _CMP_GT_OQ);
+        __m256 vValue = _mm256_blendv_ps(top, bottom, pastBottom);
+        __m256 vNormal = _mm256_blendv_ps(minusOne, one, pastBottom);
+
+        __m256 alongH = _mm256_add_ps(_mm256_xor_ps(_mm256_sub_ps(left, pointX), signBit), _mm256_mul_ps(zero, _mm256_sub_ps(vValue, pointY)));
+        __m256 vX = _mm256_blendv_ps(_mm256_add_ps(left, alongH), right, _mm256_cmp_ps(alongH, width, _CMP_GE_OQ));
+        vX = _mm256_blendv_ps(vX, left, _mm256_cmp_ps(alongH, zero, _CMP_LT_OQ));
+
+        // multiply then add, rather than fused, so the results match the scalar code
+        __m256 hDX = _mm256_sub_ps(pointX, hValue);
+        __m256 hDY = _mm256_sub_ps(pointY, hY);
+        __m256 hDistance = _mm256_add_ps(_mm256_mul_ps(hDX, hDX), _mm256_mul_ps(hDY, hDY));
+
+        __m256 vDX = _mm256_sub_ps(pointX, vX);
+        __m256 vDY = _mm256_sub_ps(pointY, vValue);
+        __m256 vDistance = _mm256_add_ps(_mm256_mul_ps(vDX, vDX), _mm256_mul_ps(vDY, vDY));
+
+        __m256 useH = _mm256_cmp_ps(hDistance, vDistance, _CMP_LT_OQ);
+        _mm256_storeu_ps(results->X + i, _mm256_blendv_ps(vX, hValue, useH));
+        _mm256_storeu_ps(results->Y + i, _mm256_blendv_ps(vValue, hY, useH));
+        _mm256_storeu_ps(results->NormalX + i, _mm256_and_ps(hNormal, useH));
+        _mm256_storeu_ps(results->NormalY + i, _mm256_andnot_ps(useH, vNormal));
+        _mm256_storeu_ps(results->DistanceSqr + i, _mm256_blendv_ps(vDistance, hDistance, useH));
+    }
+
+    NearestRectanglePointsScalar(rects, point, results, i);
+}
+#endif
+
+void NearestRectanglePoints(const RectArrays* rects, Vector2 point, NearestPoints* results, NearestKernel kernel)
+{
+    switch (kernel)
+    {
+#if defined(NEAREST_X86)
+    case NearestSSE41:
+        NearestRectanglePointsSSE41(rects, point, results);
+        break;
+    case NearestAVX2:
+        NearestRectanglePointsAVX2(rects, point, results);
+        break;
+#endif
+    default:
+        NearestRectanglePointsScalar(rects, point, results, 0);
+        break;
+    }
+}
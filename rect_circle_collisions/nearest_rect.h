@@ -0,0 +1,53 @@
+#pragma once
+
+#include "raylib.h"
+
+#include <stdbool.h>
+
+// finds the nearest point on many rectangles to one point at once
+// the rectangles are stored as a structure of arrays so several of them can be done per instruction
+// the results are the same, bit for bit, as calling PointNearestRectanglePoint on each rectangle, just without the branches
+
+typedef struct RectArrays
+{
+    int Count;
+    int Capacity;
+
+    float* X;
+    float* Y;
+    float* Width;
+    float* Height;
+}RectArrays;
+
+typedef struct NearestPoints
+{
+    float* X;
+    float* Y;
+    float* NormalX;
+    float* NormalY;
+    float* DistanceSqr; // from the point to the nearest point
+}NearestPoints;
+
+typedef enum
+{
+    NearestScalar = 0,
+    NearestSSE41,
+    NearestAVX2,
+    NearestKernelCount,
+}NearestKernel;
+
+extern const char* NearestKernelNames[NearestKernelCount];
+
+bool InitRectArrays(RectArrays* rects, int capacity);
+void FreeRectArrays(RectArrays* rects);
+void AddRectToArrays(RectArrays* rects, Rectangle rect);
+
+// every array is sized for count results
+bool InitNearestPoints(NearestPoints* points, int count);
+void FreeNearestPoints(NearestPoints* points);
+
+bool NearestKernelSupported(NearestKernel kernel);
+NearestKernel GetBestNearestKernel();
+
+// fills results with the nearest point on every rectangle to point, along with the normal of the edge it is on
+void NearestRectanglePoints(const RectArrays* rects, Vector2 point, NearestPoints* results, NearestKernel kernel);
@@ -31,8 +31,28 @@
 #include "raylib.h"
 #include "raymath.h"
 
-#define RectCount 4
-Rectangle Rects[RectCount] = { {450,100,100,100}, {550,100,100,100} , {550,200,100,100 }, {50,300,50,50} };
+#include "nearest_rect.h"
+#include "rect_grid.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DefaultRectCount 4
+Rectangle DefaultRects[DefaultRectCount] = { {450,100,100,100}, {550,100,100,100} , {550,200,100,100 }, {50,300,50,50} };
+
+// press T to swap the default rectangles for a large generated field, like the colliders of a tile map
+#define FieldRectCount 10000
+#define FieldSpacing 80.0f
+
+// the rectangles the player collides with, and a grid over them so only the ones near the player are tested
+Rectangle* Rects = DefaultRects;
+int RectCount = DefaultRectCount;
+RectGrid Grid = { 0 };
+
+#define GridCellSize 64.0f
+#define MaxCandidates 256
 
 /// <summary>
 /// Returns the point on a rectangle that is nearest to a provided point
@@ -105,8 +125,302 @@ void PointNearestRectanglePoint(Rectangle rect, Vector2 point, Vector2* nearest,
     }
 }
 
-int main(void)
+// fills rects with a square field of rectangles of random sizes, one in each spot of a lattice
+void GenerateRectField(Rectangle* rects, int count, float spacing)
+{
+    int columns = 1;
+    while (columns * columns < count)
+        columns++;
+
+    for (int i = 0; i < count; i++)
+    {
+        float width = (float)(20 + rand() % 41);
+        float height = (float)(20 + rand() % 41);
+
+        float x = (i % columns) * spacing + (spacing - width) * 0.5f;
+        float y = (i / columns) * spacing + (spacing - height) * 0.5f;
+        rects[i] = (Rectangle){ x, y, width, height };
+    }
+}
+
+// broadphase benchmark
+// run with --broadphase-benchmark to compare testing every rectangle against only testing the ones the grid returns, without opening a window
+#define BENCHMARK_QUERIES 100000
+#define BENCHMARK_BRUTE_FORCE_TESTS 100000000 // brute force only runs as many queries as fit in this many rectangle tests
+#define BENCHMARK_RADIUS 25.0f
+
+const int BenchmarkSizes[] = { 1000, 10000, 100000 };
+
+double GetBenchmarkTime()
+{
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1000000000.0;
+}
+
+bool CircleHitsRect(Rectangle rect, Vector2 center, float radius)
+{
+    Vector2 hitPoint = { 0, 0 };
+    PointNearestRectanglePoint(rect, center, &hitPoint, NULL);
+    return Vector2LengthSqr(Vector2Subtract(hitPoint, center)) < radius * radius;
+}
+
+void RunBroadphaseBenchmark()
+{
+    for (int size = 0; size < sizeof(BenchmarkSizes) / sizeof(BenchmarkSizes[0]); size++)
+    {
+        int count = BenchmarkSizes[size];
+        Rectangle* rects = (Rectangle*)malloc(sizeof(Rectangle) * count);
+        Vector2* moves = (Vector2*)malloc(sizeof(Vector2) * BENCHMARK_QUERIES * 2);
+
+        srand(1234);
+        GenerateRectField(rects, count, FieldSpacing);
+
+        // random short moves anywhere over the field
+        int columns = 1;
+        while (columns * columns < count)
+            columns++;
+
+        float fieldSize = columns * FieldSpacing;
+        for (int i = 0; i < BENCHMARK_QUERIES; i++)
+        {
+            moves[i * 2] = (Vector2){ fieldSize * rand() / (float)RAND_MAX, fieldSize * rand() / (float)RAND_MAX };
+            moves[i * 2 + 1] = Vector2Add(moves[i * 2], (Vector2){ (float)(rand() % 11 - 5), (float)(rand() % 11 - 5) });
+        }
+
+        double buildStart = GetBenchmarkTime();
+        RectGrid grid;
+        BuildRectGrid(&grid, rects, count, GridCellSize);
+        double buildTime = GetBenchmarkTime() - buildStart;
+
+        int bruteQueries = BENCHMARK_BRUTE_FORCE_TESTS / count;
+        if (bruteQueries > BENCHMARK_QUERIES)
+            bruteQueries = BENCHMARK_QUERIES;
+
+        // test every rectangle against the end of each move
+        int bruteHits = 0;
+        double bruteStart = GetBenchmarkTime();
+        for (int i = 0; i < bruteQueries; i++)
+        {
+            for (int rect = 0; rect < count; rect++)
+            {
+                if (CircleHitsRect(rects[rect], moves[i * 2 + 1], BENCHMARK_RADIUS))
+                    bruteHits++;
+            }
+        }
+        double bruteTime = GetBenchmarkTime() - bruteStart;
+
+        // the same brute force test, with the batched nearest point kernel doing every rectangle at once
+        RectArrays rectArrays;
+        NearestPoints nearest;
+        InitRectArrays(&rectArrays, count);
+        InitNearestPoints(&nearest, count);
+        for (int rect = 0; rect < count; rect++)
+            AddRectToArrays(&rectArrays, rects[rect]);
+
+        NearestKernel kernel = GetBestNearestKernel();
+        int batchedHits = 0;
+        double batchedStart = GetBenchmarkTime();
+        for (int i = 0; i < bruteQueries; i++)
+        {
+            NearestRectanglePoints(&rectArrays, moves[i * 2 + 1], &nearest, kernel);
+            for (int rect = 0; rect < count; rect++)
+            {
+                if (nearest.DistanceSqr[rect] < BENCHMARK_RADIUS * BENCHMARK_RADIUS)
+                    batchedHits++;
+            }
+        }
+        double batchedTime = GetBenchmarkTime() - batchedStart;
+
+        FreeNearestPoints(&nearest);
+        FreeRectArrays(&rectArrays);
+
+        // only test the rectangles that overlap the swept bounds of each move
+        int gridHits = 0;
+        int gridHitsInBruteQueries = 0;
+        long long candidateTotal = 0;
+        int candidates[MaxCandidates];
+        double gridStart = GetBenchmarkTime();
+        for (int i = 0; i < BENCHMARK_QUERIES; i++)
+        {
+            Rectangle bounds = GetSweptCircleBounds(moves[i * 2], moves[i * 2 + 1], BENCHMARK_RADIUS);
+            int found = QueryRectGrid(&grid, bounds, candidates, MaxCandidates);
+            candidateTotal += found;
+
+            for (int c = 0; c < found; c++)
+            {
+                if (CircleHitsRect(rects[candidates[c]], moves[i * 2 + 1], BENCHMARK_RADIUS))
+                {
+                    gridHits++;
+                    if (i < bruteQueries)
+                        gridHitsInBruteQueries++;
+                }
+            }
+        }
+        double gridTime = GetBenchmarkTime() - gridStart;
+
+        printf("%6d rects, grid %dx%d built in %.2f ms\n", count, grid.Columns, grid.Rows, buildTime * 1000.0);
+        double bruteQueryTime = bruteTime / bruteQueries;
+        double gridQueryTime = gridTime / BENCHMARK_QUERIES;
+        printf("    brute force %9.3f us per query, %d hits in %d queries\n", bruteQueryTime * 1000000.0, bruteHits, bruteQueries);
+        printf("    %-11s %9.3f us per query, %d hits in %d queries\n", NearestKernelNames[kernel], batchedTime / bruteQueries * 1000000.0, batchedHits, bruteQueries);
+        printf("    broadphase  %9.3f us per query, %d hits in %d queries, %.2f candidates per query, %.0fx faster\n", gridQueryTime * 1000000.0, gridHits, BENCHMARK_QUERIES, (double)candidateTotal / BENCHMARK_QUERIES, bruteQueryTime / gridQueryTime);
+
+        if (bruteHits != gridHitsInBruteQueries || bruteHits != batchedHits)
+            printf("    the broadphase missed hits!\n");
+
+        FreeRectGrid(&grid);
+        free(moves);
+        free(rects);
+    }
+}
+
+// nearest point self check
+// run with --nearest-self-check to compare every batched nearest point kernel against PointNearestRectanglePoint on random rectangles and points
+// the results have to match bit for bit, including which edge the normal is on
+#define SELF_CHECK_RECTS 4096
+#define SELF_CHECK_POINTS 2000
+
+// random values with plenty of exact ties, points on edges and corners are where the branches are easiest to get wrong
+float RandomCoordinate()
+{
+    switch (rand() % 4)
+    {
+    case 0:
+        return (float)(rand() % 201 - 100);
+    case 1:
+        return (float)(rand() % 2001 - 1000) * 0.25f;
+    default:
+        return ((float)rand() / (float)RAND_MAX) * 2000.0f - 1000.0f;
+    }
+}
+
+float RandomSize()
+{
+    switch (rand() % 8)
+    {
+    case 0:
+        return 0;
+    case 1:
+        return (float)(rand() % 50);
+    default:
+        return ((float)rand() / (float)RAND_MAX) * 400.0f;
+    }
+}
+
+bool SameBits(float a, float b)
+{
+    return memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+int RunNearestSelfCheck()
+{
+    RectArrays rects;
+    NearestPoints results;
+    InitRectArrays(&rects, SELF_CHECK_RECTS);
+    InitNearestPoints(&results, SELF_CHECK_RECTS);
+
+    srand(4321);
+    for (int i = 0; i < SELF_CHECK_RECTS; i++)
+        AddRectToArrays(&rects, (Rectangle){ RandomCoordinate(), RandomCoordinate(), RandomSize(), RandomSize() });
+
+    // some rectangles sit exactly on -0, so the sign of zero is checked too
+    for (int i = 0; i < SELF_CHECK_RECTS; i += 16)
+    {
+        rects.X[i] = -0.0f;
+        rects.Y[i + 1] = -0.0f;
+    }
+
+    int failures = 0;
+    for (int kernel = 0; kernel < NearestKernelCount; kernel++)
+    {
+        if (!NearestKernelSupported((NearestKernel)kernel))
+        {
+            printf("%-7s not supported on this CPU\n", NearestKernelNames[kernel]);
+            continue;
+        }
+
+        int mismatches = 0;
+        srand(8765);
+        for (int p = 0; p < SELF_CHECK_POINTS; p++)
+        {
+            Vector2 point = { RandomCoordinate(), RandomCoordinate() };
+
+            // put some points right on a corner or an edge of a rectangle
+            if (p % 4 == 0)
+            {
+                int rect = rand() % SELF_CHECK_RECTS;
+                point.x = rects.X[rect] + (rand() % 2) * rects.Width[rect];
+                point.y = (p % 8 == 0) ? rects.Y[rect] + (rand() % 2) * rects.Height[rect] : point.y;
+            }
+            else if (p % 8 == 1)
+                point.x = (p % 16 == 1) ? -0.0f : 0.0f;
+            else if (p % 8 == 3)
+                point.y = (p % 16 == 3) ? -0.0f : 0.0f;
+
+            NearestRectanglePoints(&rects, point, &results, (NearestKernel)kernel);
+
+            for (int i = 0; i < rects.Count; i++)
+            {
+                Rectangle rect = { rects.X[i], rects.Y[i], rects.Width[i], rects.Height[i] };
+                Vector2 nearest = { 0, 0 };
+                Vector2 normal = { 0, 0 };
+                PointNearestRectanglePoint(rect, point, &nearest, &normal);
+                float distanceSqr = Vector2LengthSqr(Vector2Subtract(point, nearest));
+
+                if (!SameBits(nearest.x, results.X[i]) || !SameBits(nearest.y, results.Y[i]) ||
+                    !SameBits(normal.x, results.NormalX[i]) || !SameBits(normal.y, results.NormalY[i]) ||
+                    !SameBits(distanceSqr, results.DistanceSqr[i]))
+                {
+                    if (mismatches < 5)
+                        printf("    rect %d point %g,%g expected %g,%g got %g,%g\n", i, point.x, point.y, nearest.x, nearest.y, results.X[i], results.Y[i]);
+                    mismatches++;
+                }
+            }
+        }
+
+        printf("%-7s %d mismatches in %d tests\n", NearestKernelNames[kernel], mismatches, SELF_CHECK_RECTS * SELF_CHECK_POINTS);
+        failures += mismatches;
+    }
+
+    FreeNearestPoints(&results);
+    FreeRectArrays(&rects);
+
+    return failures == 0 ? 0 : 1;
+}
+
+// swaps between the default rectangles and a generated field, and rebuilds the grid for them
+void ToggleRectField()
+{
+    FreeRectGrid(&Grid);
+
+    if (Rects == DefaultRects)
+    {
+        Rects = (Rectangle*)malloc(sizeof(Rectangle) * FieldRectCount);
+        RectCount = FieldRectCount;
+        GenerateRectField(Rects, RectCount, FieldSpacing);
+    }
+    else
+    {
+        free(Rects);
+        Rects = DefaultRects;
+        RectCount = DefaultRectCount;
+    }
+
+    BuildRectGrid(&Grid, Rects, RectCount, GridCellSize);
+}
+
+int main(int argc, char* argv[])
 {
+    if (argc > 1 && strcmp(argv[1], "--broadphase-benchmark") == 0)
+    {
+        RunBroadphaseBenchmark();
+        return 0;
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--nearest-self-check") == 0)
+        return RunNearestSelfCheck();
+
     // Initialization
     //--------------------------------------------------------------------------------------
     const int screenWidth = 800;
@@ -121,9 +435,20 @@ int main(void)
 
     float Radius = 25;
 
+    BuildRectGrid(&Grid, Rects, RectCount, GridCellSize);
+
+    // follows the player, so the whole of a generated field can be explored
+    Camera2D camera = { 0 };
+    camera.offset = (Vector2){ screenWidth * 0.5f, screenHeight * 0.5f };
+    camera.target = camera.offset;
+    camera.zoom = 1;
+
     // Main game loop
     while (!WindowShouldClose())    // Detect window close button or ESC key
     {
+        if (IsKeyPressed(KEY_T))
+            ToggleRectField();
+
         if (IsKeyDown(KEY_A))
         {
             Matrix mat = MatrixRotateZ(180 * DEG2RAD * GetFrameTime());
@@ -147,9 +472,15 @@ int main(void)
         Vector2 intersectPoint[2] = { { -100,-100 },{ -100,-100 } };
         bool collided = false;
 
+        // only the rectangles near where the player is moving can be hit
+        int candidates[MaxCandidates];
+        int candidateCount = QueryRectGrid(&Grid, GetSweptCircleBounds(PlayerOrigin, newPosOrigin, Radius), candidates, MaxCandidates);
+
         int collisionCount = 0;
-        for (int i = 0; i < RectCount; i++)
+        for (int c = 0; c < candidateCount; c++)
         {
+            int i = candidates[c];
+
             Vector2 hitPoint = { -100,-100 };
             Vector2 hitNormal = { 0, 0 };
             PointNearestRectanglePoint(Rects[i], newPosOrigin, &hitPoint, &hitNormal);
@@ -161,7 +492,8 @@ int main(void)
             if (inside)
 			{
                 collided = true;
-                intersectPoint[collisionCount++] = hitPoint;
+                if (collisionCount < 2)
+                    intersectPoint[collisionCount++] = hitPoint;
 
                 // normalize the vector along the point to where we are nearest
                 vectorToHit = Vector2Normalize(vectorToHit);
@@ -184,20 +516,39 @@ int main(void)
 
         PlayerOrigin = newPosOrigin;
 
+        if (Rects != DefaultRects)
+            camera.target = PlayerOrigin;
+        else
+            camera.target = camera.offset;
+
         BeginDrawing();
             ClearBackground(BLACK);
+            BeginMode2D(camera);
 
             for (int i = 0; i < RectCount; i++)
                 DrawRectangleRec(Rects[i], RED);
 
+            // the rectangles the grid said were worth testing
+            for (int c = 0; c < candidateCount; c++)
+                DrawRectangleLinesEx(Rects[candidates[c]], 2, ORANGE);
+
             DrawCircleV(PlayerOrigin, collided ? 10.0f : 2.0f, collided ? YELLOW : DARKGREEN);
             DrawCircleLinesV(PlayerOrigin, Radius, DARKGREEN);
             DrawLineV(PlayerOrigin, Vector2Add(PlayerOrigin, Vector2Scale(PlayerDirection, Radius)), GREEN);
             for (int i = 0; i < 2; i++)
                 DrawCircleV(intersectPoint[i], 5, PURPLE);
 
+            EndMode2D();
+
+            DrawText(TextFormat("%d rects, %d tested, T = toggle rect field", RectCount, candidateCount), 2, screenHeight - 20, 20, WHITE);
+
         EndDrawing();
     }
+
+    if (Rects != DefaultRects)
+        free(Rects);
+    FreeRectGrid(&Grid);
+
     CloseWindow();
 
     return 0;
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "raylib.h"
+
+#include <stdbool.h>
+
+// a uniform grid over a list of static rectangles, so a query only has to look at the rectangles near it
+// the grid is built once from the list, each cell holds the index of every rectangle that touches it
+// cells are stored packed together, CellStarts[cell] to CellStarts[cell + 1] is the range in CellItems for a cell
+
+typedef struct RectGrid
+{
+    const Rectangle* Rects;
+    int RectCount;
+
+    Vector2 Origin;
+    float CellSize;
+    int Columns;
+    int Rows;
+
+    int* CellStarts;
+    int* CellItems;
+
+    // a rectangle that covers more than one cell is in each of them, so queries stamp the ones they have returned
+    unsigned int* QueryStamps;
+    unsigned int QueryStamp;
+}RectGrid;
+
+// the grid keeps a pointer to rects, so they must not move or change while it is used
+// if the rectangles cover a large area the cell size is increased to keep the number of cells reasonable
+bool BuildRectGrid(RectGrid* grid, const Rectangle* rects, int count, float cellSize);
+void FreeRectGrid(RectGrid* grid);
+
+// finds every rectangle that overlaps area and puts its index in candidates, each one only once
+// returns how many were found, up to maxCandidates
+int QueryRectGrid(RectGrid* grid, Rectangle area, int* candidates, int maxCandidates);
+
+// the bounds of a circle moving from start to end, anything it could hit along the way overlaps this
+Rectangle GetSweptCircleBounds(Vector2 start, Vector2 end, float radius);
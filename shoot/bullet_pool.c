@@ -0,0 +1,72 @@
+#include "bullet_pool.h"
+
+#include <stdlib.h>
+
+bool InitBulletPool(BulletPool* pool, int capacity)
+{
+    pool->Capacity = capacity;
+    pool->Live = (int*)malloc(sizeof(int) * capacity);
+    pool->Links = (int*)malloc(sizeof(int) * capacity);
+
+    if (!pool->Live || !pool->Links)
+    {
+        FreeBulletPool(pool);
+        return false;
+    }
+
+    ClearBulletPool(pool);
+    return true;
+}
+
+void FreeBulletPool(BulletPool* pool)
+{
+    free(pool->Live);
+    free(pool->Links);
+
+    pool->Live = NULL;
+    pool->Links = NULL;
+    pool->Capacity = 0;
+    pool->Count = 0;
+    pool->FirstFree = -1;
+}
+
+int SpawnBullet(BulletPool* pool)
+{
+    int slot = pool->FirstFree;
+    if (slot < 0)
+        return -1;
+
+    pool->FirstFree = pool->Links[slot];
+
+    pool->Live[pool->Count] = slot;
+    pool->Links[slot] = pool->Count;
+    pool->Count++;
+
+    return slot;
+}
+
+void DespawnBullet(BulletPool* pool, int slot)
+{
+    // move the last live slot into the hole
+    int position = pool->Links[slot];
+    int last = pool->Live[--pool->Count];
+    pool->Live[position] = last;
+    pool->Links[last] = position;
+
+    pool->Links[slot] = pool->FirstFree;
+    pool->FirstFree = slot;
+}
+
+void ClearBulletPool(BulletPool* pool)
+{
+    pool->Count = 0;
+
+    // chain the slots in order, so the first bullets use the first slots
+    for (int i = 0; i < pool->Capacity; i++)
+        pool->Links[i] = i + 1;
+
+    if (pool->Capacity > 0)
+        pool->Links[pool->Capacity - 1] = -1;
+
+    pool->FirstFree = pool->Capacity > 0 ? 0 : -1;
+}
@@ -0,0 +1,165 @@
+#include "decals.h"
+#include "sprite_batch.h"
+
+#include <stdlib.h>
+
+bool InitDecalRing(DecalRing* ring, int capacity, float lifetime)
+{
+    ring->Capacity = capacity;
+    ring->Head = 0;
+    ring->Count = 0;
+    ring->Lifetime = lifetime;
+
+    ring->Positions = (Vector2*)malloc(sizeof(Vector2) * capacity);
+    ring->Angles = (float*)malloc(sizeof(float) * capacity);
+    ring->SpawnTimes = (double*)malloc(sizeof(double) * capacity);
+    ring->Colors = (Color*)malloc(sizeof(Color) * capacity);
+
+    ring->Texture = (Texture2D){ 0 };
+    ring->Source = (Rectangle){ 0 };
+    ring->QuadCount = 0;
+    ring->Tint = WHITE;
+
+    ring->Bake = false;
+    ring->BakeAlpha = 0;
+    ring->BakeLayer = (RenderTexture2D){ 0 };
+
+    if (!ring->Positions || !ring->Angles || !ring->SpawnTimes || !ring->Colors)
+    {
+        FreeDecalRing(ring);
+        return false;
+    }
+
+    return true;
+}
+
+void FreeDecalRing(DecalRing* ring)
+{
+    free(ring->Positions);
+    free(ring->Angles);
+    free(ring->SpawnTimes);
+    free(ring->Colors);
+
+    ring->Positions = NULL;
+    ring->Angles = NULL;
+    ring->SpawnTimes = NULL;
+    ring->Colors = NULL;
+    ring->Capacity = 0;
+    ring->Count = 0;
+
+    if (ring->BakeLayer.id != 0)
+        UnloadRenderTexture(ring->BakeLayer);
+
+    ring->BakeLayer = (RenderTexture2D){ 0 };
+    ring->Bake = false;
+}
+
+void SetDecalLook(DecalRing* ring, Texture2D texture, Rectangle source, const Rectangle* quads, int quadCount, Color tint)
+{
+    if (quadCount > MAX_DECAL_QUADS)
+        quadCount = MAX_DECAL_QUADS;
+
+    ring->Texture = texture;
+    ring->Source = source;
+    ring->QuadCount = quadCount;
+    ring->Tint = tint;
+
+    for (int i = 0; i < quadCount; i++)
+        ring->Quads[i] = quads[i];
+}
+
+void AddDecal(DecalRing* ring, Vector2 position, float angle, double time)
+{
+    if (ring->Capacity == 0)
+        return;
+
+    if (ring->Count == ring->Capacity)
+    {
+        ring->Head = (ring->Head + 1) % ring->Capacity;
+        ring->Count--;
+    }
+
+    int index = (ring->Head + ring->Count) % ring->Capacity;
+    ring->Positions[index] = position;
+    ring->Angles[index] = angle;
+    ring->SpawnTimes[index] = time;
+    ring->Count++;
+}
+
+void EnableDecalBaking(DecalRing* ring, float bakeAlpha)
+{
+    if (ring->BakeLayer.id == 0)
+    {
+        ring->BakeLayer = LoadRenderTexture(GetScreenWidth(), GetScreenHeight());
+
+        BeginTextureMode(ring->BakeLayer);
+        ClearBackground(BLANK);
+        EndTextureMode();
+    }
+
+    ring->Bake = true;
+    ring->BakeAlpha = bakeAlpha;
+}
+
+// draws count decals starting at first, splitting the range where it wraps around the end of the ring
+// colors can be NULL to draw them all with tint
+static void DrawDecalRange(DecalRing* ring, int first, int count, const Color* colors, Color tint)
+{
+    while (count > 0)
+    {
+        int span = ring->Capacity - first;
+        if (span > count)
+            span = count;
+
+        for (int quad = 0; quad < ring->QuadCount; quad++)
+            DrawSpriteBatch(ring->Texture, ring->Source, ring->Quads[quad], ring->Positions + first, ring->Angles + first, colors ? colors + first : NULL, tint, span);
+
+        first = (first + span) % ring->Capacity;
+        count -= span;
+    }
+}
+
+void ExpireDecals(DecalRing* ring, double time)
+{
+    // the oldest decals are at the head, so stop at the first one that is still alive
+    int expired = 0;
+    while (expired < ring->Count && time - ring->SpawnTimes[(ring->Head + expired) % ring->Capacity] >= ring->Lifetime)
+        expired++;
+
+    if (expired == 0)
+        return;
+
+    if (ring->Bake && ring->BakeLayer.id != 0)
+    {
+        BeginTextureMode(ring->BakeLayer);
+        DrawDecalRange(ring, ring->Head, expired, NULL, ColorAlpha(ring->Tint, ring->BakeAlpha * ring->Tint.a / 255.0f));
+        EndTextureMode();
+    }
+
+    ring->Head = (ring->Head + expired) % ring->Capacity;
+    ring->Count -= expired;
+}
+
+void DrawDecals(DecalRing* ring, double time)
+{
+    if (ring->Bake && ring->BakeLayer.id != 0)
+    {
+        // render textures are upside down
+        Rectangle layerSource = { 0, 0, (float)ring->BakeLayer.texture.width, -(float)ring->BakeLayer.texture.height };
+        DrawTextureRec(ring->BakeLayer.texture, layerSource, (Vector2){ 0, 0 }, WHITE);
+    }
+
+    // work out how faded each decal is from its age
+    for (int i = 0; i < ring->Count; i++)
+    {
+        int index = (ring->Head + i) % ring->Capacity;
+
+        float fade = 1.0f - (float)(time - ring->SpawnTimes[index]) / ring->Lifetime;
+        if (fade < 0)
+            fade = 0;
+
+        ring->Colors[index] = ColorAlpha(ring->Tint, fade * ring->Tint.a / 255.0f);
+    }
+
+    DrawDecalRange(ring, ring->Head, ring->Count, ring->Colors, ring->Tint);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "raylib.h"
+
+#include <stdbool.h>
+
+// marks left on the ground, like treadmarks, scorch marks or footprints
+// decals are always added in time order and all live for the same time, so the oldest one is always the next to expire
+// that makes a ring buffer enough, adding and expiring are O(1), and nothing has to be searched for or updated each frame
+// a decal fades out based on how long ago it was added, so its age is worked out when it is drawn
+// when baking is on, decals that expire are drawn into a render texture that is kept forever, so the ground remembers them
+
+// how many quads can make up one decal
+#define MAX_DECAL_QUADS 4
+
+typedef struct DecalRing
+{
+    int Capacity;
+    int Head;   // the oldest decal
+    int Count;
+
+    float Lifetime;
+
+    // what every decal looks like, drawn with the sprite batch
+    // a texture with an id of 0 draws solid quads, the alpha of Tint is faded to 0 over the lifetime
+    Texture2D Texture;
+    Rectangle Source;
+    Rectangle Quads[MAX_DECAL_QUADS];
+    int QuadCount;
+    Color Tint;
+
+    Vector2* Positions;
+    float* Angles;
+    double* SpawnTimes;
+
+    // filled in when drawing, with the faded color of each decal
+    Color* Colors;
+
+    bool Bake;
+    float BakeAlpha; // how strong baked decals are, compared to new ones
+    RenderTexture2D BakeLayer;
+}DecalRing;
+
+bool InitDecalRing(DecalRing* ring, int capacity, float lifetime);
+
+// quads are in the decal's own space, like the quad passed to DrawSpriteBatch
+void SetDecalLook(DecalRing* ring, Texture2D texture, Rectangle source, const Rectangle* quads, int quadCount, Color tint);
+void FreeDecalRing(DecalRing* ring);
+
+// when the ring is full the oldest decal is dropped to make room
+void AddDecal(DecalRing* ring, Vector2 position, float angle, double time);
+
+// makes a layer the size of the screen that expired decals are baked into
+void EnableDecalBaking(DecalRing* ring, float bakeAlpha);
+
+// removes the decals that are older than the lifetime, baking them first if baking is on
+// baking draws into a render texture, so call this outside of any other texture mode
+void ExpireDecals(DecalRing* ring, double time);
+
+// draws the baked layer, then every live decal
+void DrawDecals(DecalRing* ring, double time);
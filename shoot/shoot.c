@@ -32,27 +32,27 @@
 #include "raymath.h"
 #include "rlgl.h"
 
+#include "bullet_pool.h"
+#include "decals.h"
+#include "sprite_batch.h"
+
 // constants
 const float BulletSpeed = 600.0f;
 const float MaxBulletLife = 2.0f;
 #define MaxBullets 64
 const float ShotReloadTime = 0.125f;
 
-#define MaxTreadMarks 32
+#define MaxTreadMarks 100000
 
 const float TreadmarkGenerationTime = 0.1f;
+const float TreadmarkLifetime = 1.0f;
+const float BakedTreadmarkAlpha = 0.2f;
 
 const float RotationSpeed = 270;
 const float MoveSpeed = 200;
 
-// treadmark data
-typedef struct Treadmark
-{
-    float Lifetime;
-    Vector2 Position;
-    float Angle;
-}Treadmark;
-Treadmark Treadmarks[MaxTreadMarks] = { 0 };
+// treadmark data, the marks fade out based on when they were made, so nothing is updated for them each frame
+DecalRing Treadmarks = { 0 };
 
 // player data
 Vector2 PlayerPos = { 0, 0 };
@@ -69,11 +69,34 @@ typedef struct Bullet
 }Bullet;
 Bullet Bullets[MaxBullets] = { 0 };
 
+// the bullet slots that are in use, so we never have to search for a free slot or look at dead bullets
+BulletPool ActiveBullets = { 0 };
+
+// bullets are drawn as sprites, so they can all be sent in one batch
+Texture2D BulletTexture = { 0 };
+const float BulletRadius = 5;
+
+// scratch array for gathering bullet positions, the sprite batch wants them in their own array
+Vector2 DrawPositions[MaxBullets];
+
 // initialization
 void GameInit()
 {
     // start the player in the center
     PlayerPos =(Vector2){ GetScreenWidth() * 0.5f, GetScreenHeight() * 0.5f};
+
+    InitBulletPool(&ActiveBullets, MaxBullets);
+
+    // a white circle, the batch tints it
+    Image circle = GenImageColor((int)BulletRadius * 2 + 1, (int)BulletRadius * 2 + 1, BLANK);
+    ImageDrawCircle(&circle, (int)BulletRadius, (int)BulletRadius, (int)BulletRadius, WHITE);
+    BulletTexture = LoadTextureFromImage(circle);
+    UnloadImage(circle);
+
+    // treadmarks are two solid rectangles, where the treads are on the tank
+    Rectangle treads[2] = { { -15,10, 30,5 }, { -15,-15, 30,5 } };
+    InitDecalRing(&Treadmarks, MaxTreadMarks, TreadmarkLifetime);
+    SetDecalLook(&Treadmarks, (Texture2D){ 0 }, (Rectangle){ 0 }, treads, 2, ColorAlpha(GRAY, 0.75f));
 }
 
 // game logic update
@@ -97,29 +120,24 @@ bool GameUpdate()
     // Optional TODO
     // ensure the player stays on screen or do collisions with any obstacles
 
-    // update treadmarks so they fade out over time
-    for (int i = 0; i < MaxTreadMarks; i++)
+    // toggle baking old treadmarks into the ground
+    if (IsKeyPressed(KEY_B))
     {
-        if (Treadmarks[i].Lifetime > 0)
-            Treadmarks[i].Lifetime -= GetFrameTime();
+        if (Treadmarks.Bake)
+            Treadmarks.Bake = false;
+        else
+            EnableDecalBaking(&Treadmarks, BakedTreadmarkAlpha);
     }
 
+    // let old treadmarks go
+    ExpireDecals(&Treadmarks, GetTime());
+
     // add a new teadmark
     LastTreadMarkTime -= GetFrameTime();
     while (LastTreadMarkTime <= 0)
     {
         LastTreadMarkTime += TreadmarkGenerationTime;
-        for (int i = 0; i < MaxTreadMarks; i++)
-        {
-            if (Treadmarks[i].Lifetime <= 0)
-            {
-                Treadmarks[i].Lifetime = 1;
-                Treadmarks[i].Position = PlayerPos;
-                Treadmarks[i].Angle = PlayerAngle;
-
-                break;
-            }
-        }
+        AddDecal(&Treadmarks, PlayerPos, PlayerAngle, GetTime());
     }
 
     // update the shot time
@@ -127,37 +145,41 @@ bool GameUpdate()
         LastShotTime -= GetFrameTime();
 
     // update bullet positions, and let old bullets die
-    for (int i = 0; i < MaxBullets; i++)
+    for (int i = 0; i < ActiveBullets.Count;)
     {
-        if (Bullets[i].Lifetime > 0)
-        {
-            Bullets[i].Lifetime -= GetFrameTime();
-            Bullets[i].Position = Vector2Add(Bullets[i].Position, Vector2Scale(Bullets[i].Direction, GetFrameTime()));
+        int slot = ActiveBullets.Live[i];
 
-            // Optional TODO,
-            // check if the bullet is off the screen and kill it
+        Bullets[slot].Lifetime -= GetFrameTime();
+        if (Bullets[slot].Lifetime <= 0)
+        {
+            // the last live bullet gets moved into this spot, so don't advance
+            DespawnBullet(&ActiveBullets, slot);
+            continue;
         }
+
+        Bullets[slot].Position = Vector2Add(Bullets[slot].Position, Vector2Scale(Bullets[slot].Direction, GetFrameTime()));
+
+        // Optional TODO,
+        // check if the bullet is off the screen and kill it
+        i++;
     }
 
     // shoot
     if (IsKeyDown(KEY_SPACE) && LastShotTime <= 0)
     {
-        for (int i = 0; i < MaxBullets; i++)
+        // get a free bullet slot, if there is one
+        int slot = SpawnBullet(&ActiveBullets);
+        if (slot >= 0)
         {
-            // find the first empty bullet slot
-            if (Bullets[i].Lifetime <= 0)
-            {
-                // add a new bullet a little distance away from the player
-                Bullets[i].Position = Vector2Add(PlayerPos, Vector2Scale(facing, 30));
-                Bullets[i].Direction = Vector2Scale(facing, BulletSpeed); // scale the bullet direction by the speed
-                    
-                Bullets[i].Lifetime = MaxBulletLife;
-                LastShotTime = ShotReloadTime;
-
-                // Optional TODO
-                // play a sound
-                break;
-            }
+            // add a new bullet a little distance away from the player
+            Bullets[slot].Position = Vector2Add(PlayerPos, Vector2Scale(facing, 30));
+            Bullets[slot].Direction = Vector2Scale(facing, BulletSpeed); // scale the bullet direction by the speed
+
+            Bullets[slot].Lifetime = MaxBulletLife;
+            LastShotTime = ShotReloadTime;
+
+            // Optional TODO
+            // play a sound
         }
     }
 
@@ -170,28 +192,8 @@ void GameDraw()
     BeginDrawing();
     ClearBackground(DARKGRAY);
 
-    // track how many active bullets and marks there are
-    int marks = 0;
-    int bullets = 0;
-
-    // draw each treadmark, fading it out over time
-    for (int i = 0; i < MaxTreadMarks; i++)
-    {
-        if (Treadmarks[i].Lifetime > 0)
-        {
-            // set the transform matrix to where the treadmark is
-            rlPushMatrix();
-            rlTranslatef(Treadmarks[i].Position.x, Treadmarks[i].Position.y, 0);
-            rlRotatef(Treadmarks[i].Angle, 0, 0, 1);
-
-            Color color = ColorAlpha(GRAY, Treadmarks[i].Lifetime * 0.75f);
-
-            DrawRectangleRec((Rectangle){ -15,10, 30,5 }, color);
-            DrawRectangleRec((Rectangle){ -15,-15, 30,5 }, color);
-            rlPopMatrix();
-            marks++;
-        }
-    }
+    // draw the treadmarks, fading them out over time
+    DrawDecals(&Treadmarks, GetTime());
 
     // draw the player
     // set the transform matrix to where the player is and it's angle
@@ -208,20 +210,18 @@ void GameDraw()
     // reset the transform matrix
     rlPopMatrix();
 
-    // draw each bullet
-    for (int i = 0; i < MaxBullets; i++)
-    {
-        if (Bullets[i].Lifetime > 0)
-        {
-            DrawCircleV(Bullets[i].Position, 5, RED);
-            bullets++;
-        }
-    }
+    // draw every bullet in one batch
+    for (int i = 0; i < ActiveBullets.Count; i++)
+        DrawPositions[i] = Bullets[ActiveBullets.Live[i]].Position;
+
+    Rectangle bulletSource = { 0, 0, (float)BulletTexture.width, (float)BulletTexture.height };
+    Rectangle bulletQuad = { -BulletTexture.width * 0.5f, -BulletTexture.height * 0.5f, (float)BulletTexture.width, (float)BulletTexture.height };
+    DrawSpriteBatch(BulletTexture, bulletSource, bulletQuad, DrawPositions, NULL, NULL, RED, ActiveBullets.Count);
 
     // instructions and stats
     DrawFPS(0, 0);
-    DrawText("A/D = rotation W/S = movement Space = shoot", 2, GetScreenHeight() - 20, 20, BLACK);
-    DrawText(TextFormat("%d Bullets, %d Marks", bullets, marks), GetScreenWidth() - 200, GetScreenHeight() - 20, 20, RED);
+    DrawText("A/D = rotation W/S = movement Space = shoot B = bake treadmarks", 2, GetScreenHeight() - 20, 20, BLACK);
+    DrawText(TextFormat("%d Bullets, %d Marks", ActiveBullets.Count, Treadmarks.Count), GetScreenWidth() - 200, GetScreenHeight() - 20, 20, RED);
     EndDrawing();
 }
 
@@ -241,6 +241,10 @@ int main()
         GameDraw();
     }
 
+    FreeBulletPool(&ActiveBullets);
+    UnloadTexture(BulletTexture);
+    FreeDecalRing(&Treadmarks);
+
     CloseWindow();
     return 0;
 }
\ No newline at end of file
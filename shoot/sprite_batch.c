@@ -0,0 +1,89 @@
+#include "sprite_batch.h"
+
+#include "rlgl.h"
+
+#include <math.h>
+
+// how many sprites are rotated at once, small enough that the corners fit on the stack and always fit in an rlgl batch
+#define SPRITE_BATCH_CHUNK 256
+
+void DrawSpriteBatch(Texture2D texture, Rectangle source, Rectangle quad, const Vector2* positions, const float* angles, const Color* colors, Color tint, int count)
+{
+    unsigned int textureId = texture.id;
+    float left = 0, top = 0, right = 1, bottom = 1;
+
+    if (textureId == 0)
+    {
+        textureId = rlGetTextureIdDefault();
+    }
+    else
+    {
+        left = source.x / texture.width;
+        top = source.y / texture.height;
+        right = (source.x + source.width) / texture.width;
+        bottom = (source.y + source.height) / texture.height;
+    }
+
+    // the corners in the same order DrawTexturePro uses, top left, bottom left, bottom right, top right
+    const float cornerX[4] = { quad.x, quad.x, quad.x + quad.width, quad.x + quad.width };
+    const float cornerY[4] = { quad.y, quad.y + quad.height, quad.y + quad.height, quad.y };
+    const float cornerU[4] = { left, left, right, right };
+    const float cornerV[4] = { top, bottom, bottom, top };
+
+    float cosines[SPRITE_BATCH_CHUNK];
+    float sines[SPRITE_BATCH_CHUNK];
+    float vertexX[4][SPRITE_BATCH_CHUNK];
+    float vertexY[4][SPRITE_BATCH_CHUNK];
+
+    for (int start = 0; start < count; start += SPRITE_BATCH_CHUNK)
+    {
+        int chunk = count - start;
+        if (chunk > SPRITE_BATCH_CHUNK)
+            chunk = SPRITE_BATCH_CHUNK;
+
+        const Vector2* chunkPositions = positions + start;
+
+        for (int i = 0; i < chunk; i++)
+        {
+            float angle = angles ? angles[start + i] * DEG2RAD : 0;
+            cosines[i] = cosf(angle);
+            sines[i] = sinf(angle);
+        }
+
+        // straight loops over plain arrays, so the compiler can do several sprites per instruction
+        for (int corner = 0; corner < 4; corner++)
+        {
+            float x = cornerX[corner];
+            float y = cornerY[corner];
+
+            for (int i = 0; i < chunk; i++)
+            {
+                vertexX[corner][i] = chunkPositions[i].x + x * cosines[i] - y * sines[i];
+                vertexY[corner][i] = chunkPositions[i].y + x * sines[i] + y * cosines[i];
+            }
+        }
+
+        // flushes the current batch first if this chunk won't fit
+        rlCheckRenderBatchLimit(chunk * 4);
+
+        rlSetTexture(textureId);
+        rlBegin(RL_QUADS);
+        rlNormal3f(0.0f, 0.0f, 1.0f);
+
+        for (int i = 0; i < chunk; i++)
+        {
+            Color color = colors ? colors[start + i] : tint;
+            rlColor4ub(color.r, color.g, color.b, color.a);
+
+            for (int corner = 0; corner < 4; corner++)
+            {
+                rlTexCoord2f(cornerU[corner], cornerV[corner]);
+                rlVertex2f(vertexX[corner][i], vertexY[corner][i]);
+            }
+        }
+
+        rlEnd();
+    }
+
+    rlSetTexture(0);
+}